@@ -17,10 +17,14 @@
 
 #pragma once
 
+#include "souffle/RamTypes.h"
+#include "souffle/utility/HashUtil.h"
+#include "souffle/utility/SimdUtil.h"
 #include <cstddef>
 #include <functional>
 #include <iostream>
 #include <system_error>
+#include <type_traits>
 
 namespace souffle {
 
@@ -40,6 +44,10 @@ struct Tuple {
     // the stored data
     Domain data[arity];
 
+    // comparisons locate the first differing component by a vectorized compare, unless the
+    // components span less than a vector register
+    static constexpr bool vectorCompare = std::is_integral_v<Domain> && arity * sizeof(Domain) >= 16;
+
     // constructors, destructors and assignment are default
 
     // provide access to components
@@ -54,6 +62,9 @@ struct Tuple {
 
     // a comparison operation
     bool operator==(const Tuple& other) const {
+        if constexpr (vectorCompare) {
+            return simd::firstMismatch<arity>(data, other.data) == arity;
+        }
         for (std::size_t i = 0; i < arity; i++) {
             if (data[i] != other.data[i]) return false;
         }
@@ -67,6 +78,10 @@ struct Tuple {
 
     // required to put tuples into e.g. a std::set container
     bool operator<(const Tuple& other) const {
+        if constexpr (vectorCompare) {
+            std::size_t i = simd::firstMismatch<arity>(data, other.data);
+            return i < arity && data[i] < other.data[i];
+        }
         for (std::size_t i = 0; i < arity; ++i) {
             if (data[i] < other.data[i]) return true;
             if (data[i] > other.data[i]) return false;
@@ -76,6 +91,10 @@ struct Tuple {
 
     // required to put tuples into e.g. a btree container
     bool operator>(const Tuple& other) const {
+        if constexpr (vectorCompare) {
+            std::size_t i = simd::firstMismatch<arity>(data, other.data);
+            return i < arity && data[i] > other.data[i];
+        }
         for (std::size_t i = 0; i < arity; ++i) {
             if (data[i] > other.data[i]) return true;
             if (data[i] < other.data[i]) return false;
@@ -174,6 +193,10 @@ namespace std {
 template <typename Domain, std::size_t arity>
 struct hash<souffle::Tuple<Domain, arity>> {
     size_t operator()(const souffle::Tuple<Domain, arity>& value) const {
+        // tuples of RAM values hash like records of the same content
+        if constexpr (std::is_same_v<Domain, souffle::RamDomain>) {
+            return souffle::hashDomains(value.data, arity);
+        }
         std::hash<Domain> hash;
         size_t res = 0;
         for (unsigned i = 0; i < arity; i++) {
@@ -0,0 +1,386 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file CompressedSymbolTable.h
+ *
+ * Symbol table storing its symbols compressed by a static symbol-table
+ * compressor in the style of FSST (Fast Static Symbol Table).
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/HashUtil.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/OptimisticIndex.h"
+#include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/SegmentedVector.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * @class SymbolCompressor
+ *
+ * A static compressor replacing frequent substrings of up to 8 bytes by one-byte codes.
+ *
+ * The compressor holds a table of at most 255 symbols, trained on a sample of the strings to be
+ * compressed. A compressed string is a sequence of codes; the code 255 escapes a literal byte that
+ * is not covered by the table. Every compressed string can be decompressed on its own, which gives
+ * random access to individual strings of a compressed collection.
+ */
+class SymbolCompressor {
+public:
+    /** Maximal length of a symbol of the table */
+    static constexpr size_t maxSymbolLength = 8;
+
+    /** Code escaping a literal byte */
+    static constexpr uint8_t escape = 255;
+
+private:
+    /** The symbols of the table, indexed by their code */
+    std::vector<std::string> symbols;
+
+    /** Codes of the symbols starting with a given byte, longest symbols first */
+    std::array<std::vector<uint8_t>, 256> codesByFirstByte;
+
+    /** Convenience method to find the code of the longest symbol at the given position of a string,
+     * returning the escape code if there is none */
+    uint8_t longestMatch(const char* str, size_t remaining) const {
+        for (uint8_t code : codesByFirstByte[static_cast<unsigned char>(str[0])]) {
+            const std::string& symbol = symbols[code];
+            if (symbol.size() <= remaining && memcmp(symbol.data(), str, symbol.size()) == 0) {
+                return code;
+            }
+        }
+        return escape;
+    }
+
+    /** Convenience method to install a new table of symbols */
+    void setSymbols(std::vector<std::string> table) {
+        symbols = std::move(table);
+        for (auto& codes : codesByFirstByte) {
+            codes.clear();
+        }
+        for (size_t code = 0; code < symbols.size(); ++code) {
+            codesByFirstByte[static_cast<unsigned char>(symbols[code][0])].push_back(
+                    static_cast<uint8_t>(code));
+        }
+        for (auto& codes : codesByFirstByte) {
+            std::stable_sort(codes.begin(), codes.end(),
+                    [&](uint8_t a, uint8_t b) { return symbols[a].size() > symbols[b].size(); });
+        }
+    }
+
+public:
+    /** Create a compressor with an empty table, escaping every byte. */
+    SymbolCompressor() = default;
+
+    /**
+     * Train a compressor on a sample of strings.
+     *
+     * Starting from an empty table, each generation compresses the sample with the current table and
+     * counts the occurrences of codes and of pairs of adjacent codes. The next table consists of the
+     * 255 candidates of highest gain (occurrences times length), where candidates are the current
+     * symbols, the escaped bytes and the concatenations of adjacent symbols of up to 8 bytes.
+     */
+    static SymbolCompressor train(const std::vector<std::string>& sample, size_t generations = 5) {
+        SymbolCompressor compressor;
+        for (size_t generation = 0; generation < generations; ++generation) {
+            // units of the compressed sample are the symbols of the table or escaped single bytes
+            std::unordered_map<std::string, size_t> count;
+            std::unordered_map<std::string, size_t> pairCount;
+            for (const std::string& str : sample) {
+                std::string previous;
+                for (size_t pos = 0; pos < str.size();) {
+                    uint8_t code = compressor.longestMatch(str.data() + pos, str.size() - pos);
+                    std::string unit = (code == escape) ? str.substr(pos, 1) : compressor.symbols[code];
+                    pos += unit.size();
+                    ++count[unit];
+                    if (!previous.empty() && previous.size() + unit.size() <= maxSymbolLength) {
+                        ++pairCount[previous + unit];
+                    }
+                    previous = std::move(unit);
+                }
+            }
+            for (const auto& entry : pairCount) {
+                count[entry.first] += entry.second;
+            }
+
+            // pick the candidates of highest gain
+            std::vector<std::pair<size_t, std::string>> candidates;
+            for (const auto& entry : count) {
+                candidates.emplace_back(entry.second * entry.first.size(), entry.first);
+            }
+            size_t tableSize = std::min<size_t>(escape, candidates.size());
+            std::partial_sort(candidates.begin(), candidates.begin() + tableSize, candidates.end(),
+                    [](const auto& a, const auto& b) {
+                        return a.first > b.first || (a.first == b.first && a.second < b.second);
+                    });
+            std::vector<std::string> table;
+            for (size_t i = 0; i < tableSize; ++i) {
+                table.push_back(candidates[i].second);
+            }
+            compressor.setSymbols(std::move(table));
+        }
+        return compressor;
+    }
+
+    /** The number of symbols in the table */
+    size_t size() const {
+        return symbols.size();
+    }
+
+    /** Compress a string, greedily replacing the longest symbol at each position by its code. */
+    std::string compress(std::string_view str) const {
+        std::string result;
+        result.reserve(str.size());
+        for (size_t pos = 0; pos < str.size();) {
+            uint8_t code = longestMatch(str.data() + pos, str.size() - pos);
+            result.push_back(static_cast<char>(code));
+            if (code == escape) {
+                result.push_back(str[pos++]);
+            } else {
+                pos += symbols[code].size();
+            }
+        }
+        return result;
+    }
+
+    /** Decompress a compressed string into the given buffer, replacing its content. */
+    void decompress(std::string_view compressed, std::string& buffer) const {
+        buffer.clear();
+        for (size_t pos = 0; pos < compressed.size(); ++pos) {
+            auto code = static_cast<uint8_t>(compressed[pos]);
+            if (code == escape) {
+                buffer.push_back(compressed[++pos]);
+            } else {
+                buffer.append(symbols[code]);
+            }
+        }
+    }
+};
+
+/**
+ * @class CompressedSymbolTable
+ *
+ * A symbol table storing its symbols compressed by a SymbolCompressor.
+ *
+ * It converts symbols to numbers and vice versa like SymbolTable. Symbols are hashed and stored in
+ * their compressed form, so a lookup compresses the symbol once and never decompresses stored symbols.
+ * Since there is no uncompressed copy of a symbol, resolving an index decompresses the symbol into a
+ * buffer supplied by the caller.
+ *
+ * The compressed symbols are packed back to back into chunks of storage, each preceded by a header of
+ * its hash, length and index; indices map to the offsets of the stored symbols, and the hash index of
+ * the table refers to the stored symbols in place.
+ */
+class CompressedSymbolTable {
+private:
+    /** A lock to synchronize parallel accesses */
+    mutable Lock access;
+
+    /** The compressor of the symbols */
+    const SymbolCompressor compressor;
+
+    /** The header of a compressed symbol in the storage of the table, followed by the bytes of the
+     * symbol. Stored symbols are not aligned, so the fields are copied rather than read in place. */
+    struct StoredSymbol {
+        unsigned char header[3 * sizeof(uint32_t)];
+
+        StoredSymbol(uint32_t hash, uint32_t length, uint32_t index) {
+            memcpy(header, &hash, sizeof(uint32_t));
+            memcpy(header + sizeof(uint32_t), &length, sizeof(uint32_t));
+            memcpy(header + 2 * sizeof(uint32_t), &index, sizeof(uint32_t));
+        }
+
+        uint32_t field(size_t i) const {
+            uint32_t value;
+            memcpy(&value, header + i * sizeof(uint32_t), sizeof(uint32_t));
+            return value;
+        }
+
+        uint32_t hash() const {
+            return field(0);
+        }
+
+        std::string_view bytes() const {
+            return {reinterpret_cast<const char*>(this + 1), field(1)};
+        }
+
+        size_t index() const {
+            return field(2);
+        }
+    };
+
+    /** A compressed symbol to look up, referenced together with its hash */
+    struct SymbolProbe {
+        std::string_view bytes;
+        uint32_t hash;
+
+        explicit SymbolProbe(std::string_view bytes)
+                : bytes(bytes), hash(static_cast<uint32_t>(hashString(bytes))) {}
+    };
+
+    /** Hash and equality of stored symbols and probes, used for heterogeneous lookups */
+    struct SymbolHashCompare {
+        static size_t hash(const StoredSymbol& symbol) {
+            return symbol.hash();
+        }
+        static size_t hash(const SymbolProbe& probe) {
+            return probe.hash;
+        }
+        static bool equal(const SymbolProbe& a, const StoredSymbol& b) {
+            return a.hash == b.hash() && a.bytes == b.bytes();
+        }
+    };
+
+    /** Offsets address the position within a chunk by their lower chunkBits bits, the chunk by the others */
+    static constexpr size_t chunkBits = 20;
+    static constexpr size_t maxChunkSize = size_t(1) << chunkBits;
+
+    /** Size of the first chunk; chunks double in size up to maxChunkSize, or fit a larger symbol */
+    static constexpr size_t firstChunkSize = size_t(1) << 12;
+
+    /** The chunks of the stored symbols */
+    SegmentedVector<char*> chunks;
+
+    /** Number of bytes of the chunks */
+    std::atomic<size_t> chunkBytes{0};
+
+    /** Bytes used and capacity of the last chunk; written under the lock */
+    size_t used = 0;
+    size_t capacity = 0;
+
+    /** Map indices to the offsets of stored symbols. */
+    SegmentedVector<size_t> numToStr;
+
+    /** Map compressed symbols to stored symbols; lookups of existing symbols do not write to shared
+     * memory, and inserts are serialized by the lock of the table. */
+    OptimisticIndex<StoredSymbol, SymbolHashCompare> strToNum;
+
+    /** Convenience method to find a stored symbol by its offset */
+    StoredSymbol* storedAt(size_t offset) const {
+        char* chunk = chunks[offset >> chunkBits];
+        return reinterpret_cast<StoredSymbol*>(chunk + (offset & (maxChunkSize - 1)));
+    }
+
+    /** Convenience method to append a symbol to the storage, starting a new chunk if it does not fit into
+     * the current one; returns the offset of the stored symbol */
+    size_t store(const SymbolProbe& symbol, size_t index) {
+        const size_t size = sizeof(StoredSymbol) + symbol.bytes.size();
+        if (used + size > capacity) {
+            capacity = std::max(size, chunks.empty() ? firstChunkSize : std::min(2 * capacity, maxChunkSize));
+            chunks.push_back(new char[capacity]);
+            chunkBytes += capacity;
+            used = 0;
+        }
+        // positions within a chunk fit into the lower bits; a larger symbol fills a chunk of its own
+        const size_t offset = ((chunks.size() - 1) << chunkBits) + used;
+        char* place = chunks[chunks.size() - 1] + used;
+        new (place) StoredSymbol(
+                symbol.hash, static_cast<uint32_t>(symbol.bytes.size()), static_cast<uint32_t>(index));
+        memcpy(place + sizeof(StoredSymbol), symbol.bytes.data(), symbol.bytes.size());
+        used += size;
+        return offset;
+    }
+
+    /** Convenience method to place a new compressed symbol in the table, if it does not exist, and return
+     * the index of it; otherwise return the index */
+    inline size_t newSymbolOfIndex(std::string_view compressed) {
+        const SymbolProbe symbol(compressed);
+        if (const StoredSymbol* found = strToNum.find(symbol)) {
+            return found->index();
+        }
+        auto lease = access.acquire();
+        if (const StoredSymbol* found = strToNum.find(symbol)) {
+            return found->index();
+        }
+        size_t index = numToStr.size();
+        const size_t offset = store(symbol, index);
+        numToStr.push_back(offset);
+        strToNum.reserve(1);
+        strToNum.insert(symbol, storedAt(offset));
+        return index;
+    }
+
+public:
+    /** Create a table compressing its symbols with the given compressor, e.g., one trained on a sample
+     * of the expected symbols. */
+    explicit CompressedSymbolTable(SymbolCompressor compressor) : compressor(std::move(compressor)) {}
+
+    CompressedSymbolTable(const CompressedSymbolTable&) = delete;
+    CompressedSymbolTable& operator=(const CompressedSymbolTable&) = delete;
+
+    virtual ~CompressedSymbolTable() {
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            delete[] chunks[i];
+        }
+    }
+
+    /** Find the index of a symbol in the table, inserting a new symbol if it does not exist there
+     * already. */
+    RamDomain lookup(std::string_view symbol) {
+        return static_cast<RamDomain>(newSymbolOfIndex(compressor.compress(symbol)));
+    }
+
+    /** Find a symbol in the table by its index, decompressing it into the given buffer, and return the
+     * buffer. Note that this gives an error if the index is out of bounds. */
+    const std::string& resolve(const RamDomain index, std::string& buffer) const {
+        auto pos = static_cast<size_t>(index);
+        if (pos >= size()) {
+            fatal("Error index out of bounds in call to `CompressedSymbolTable::resolve`. index = `%d`",
+                    index);
+        }
+        compressor.decompress(storedAt(numToStr[pos])->bytes(), buffer);
+        return buffer;
+    }
+
+    /** Find a symbol in the table by its index, returning it in a new string. */
+    std::string resolve(const RamDomain index) const {
+        std::string buffer;
+        resolve(index, buffer);
+        return buffer;
+    }
+
+    /* Return the size of the symbol table, being the number of symbols it currently holds. */
+    size_t size() const {
+        return numToStr.size();
+    }
+
+    /** Return the number of bytes allocated for the symbols and their indices. Must not run concurrently
+     * with inserts. */
+    size_t allocatedBytes() const {
+        return chunkBytes + chunks.capacity() * sizeof(char*) + numToStr.capacity() * sizeof(size_t) +
+               strToNum.allocatedBytes();
+    }
+
+    /** Return the ratio of the bytes allocated by this table to the bytes allocated by a plain table of
+     * the same symbols. */
+    double compressionRatio(const SymbolTable& plain) const {
+        const size_t plainBytes = plain.allocatedBytes();
+        return plainBytes == 0 ? 1.0 : static_cast<double>(allocatedBytes()) / plainBytes;
+    }
+};
+
+}  // namespace souffle
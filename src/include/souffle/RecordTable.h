@@ -19,14 +19,26 @@
 
 #include "souffle/CompiledTuple.h"
 #include "souffle/RamTypes.h"
+#include "souffle/utility/ArenaAllocator.h"
+#include "souffle/utility/HashUtil.h"
+#include "souffle/utility/OptimisticIndex.h"
+#include "souffle/utility/PageAllocator.h"
+#include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/SegmentedVector.h"
+#include "souffle/utility/SimdUtil.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <memory_resource>
+#include <new>
+#include <tuple>
 #include <unordered_map>
 #include <utility>
 #include <vector>
-#include <tbb/concurrent_vector.h>
 #include <tbb/concurrent_hash_map.h>
 
 namespace souffle {
@@ -36,63 +48,101 @@ class RecordMap {
     /** arity of record */
     const size_t arity;
 
-    /** hash function for unordered record map */
+    /** a record to be looked up, referenced together with its hash */
+    struct RecordProbe {
+        const RamDomain* data;
+        size_t size;
+        size_t hash;
+        RecordProbe(const RamDomain* data, size_t size)
+                : data(data), size(size), hash(hashDomains(data, size)) {}
+    };
+
+    /** a stored record; its hash is computed once and kept alongside, and its elements follow it in
+     * the same allocation */
+    struct HashedRecord {
+        size_t size;
+        size_t hash;
+        RamDomain index;
+        HashedRecord(const RecordProbe& probe, RamDomain index)
+                : size(probe.size), hash(probe.hash), index(index) {
+            std::copy_n(probe.data, probe.size, data());
+        }
+
+        RamDomain* data() {
+            return reinterpret_cast<RamDomain*>(this + 1);
+        }
+        const RamDomain* data() const {
+            return reinterpret_cast<const RamDomain*>(this + 1);
+        }
+    };
+
+    /** hash function for unordered record map; records of different hashes are never compared */
     struct RecordHash {
-        static size_t hash( const std::vector<RamDomain>& record ) {
-            std::size_t seed = 0;
-            std::hash<RamDomain> domainHash;
-            for (RamDomain value : record) {
-                seed ^= domainHash(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
-            }
-            return seed;
+        using is_transparent = void;
+        static size_t hash(const HashedRecord& record) {
+            return record.hash;
+        }
+        static size_t hash(const RecordProbe& probe) {
+            return probe.hash;
         }
-        static bool equal( const std::vector<RamDomain>& a, const std::vector<RamDomain>& b ) {
-            return a==b;
+        static bool equal(const RecordProbe& a, const HashedRecord& b) {
+            return a.hash == b.hash && a.size == b.size && simd::equal(a.data, b.data(), a.size);
         }
     };
 
-    /** map from records to references */
-    tbb::concurrent_hash_map<std::vector<RamDomain>, RamDomain, RecordHash> recordToIndex;
+    using IndexMap = OptimisticIndex<HashedRecord, RecordHash>;
+
+    /** map from records to references; lookups of existing records do not write to shared memory */
+    IndexMap recordToIndex;
+
+    /** storage of the records, released with the map */
+    Arena records;
 
     /** array of records; index represents record reference */
-    tbb::concurrent_vector<const RamDomain*> indexToRecord;
+    SegmentedVector<const RamDomain*> indexToRecord;
+
+    /** lock serializing the insertion of new records */
+    Lock insertion;
+
+    /** convenience method to convert a record to a record reference; the record is only
+     * copied if it is new */
+    RamDomain pack(const RecordProbe& probe) {
+        if (const HashedRecord* found = recordToIndex.find(probe)) {
+            return found->index;
+        }
+
+        auto lease = insertion.acquire();
+        if (const HashedRecord* found = recordToIndex.find(probe)) {
+            return found->index;
+        }
+        auto index = static_cast<RamDomain>(indexToRecord.size());
+
+        // assert that new index is smaller than the range
+        assert(index != std::numeric_limits<RamDomain>::max());
+
+        const size_t bytes = sizeof(HashedRecord) + probe.size * sizeof(RamDomain);
+        auto* stored = new (records.allocate(bytes, alignof(HashedRecord))) HashedRecord(probe, index);
+        indexToRecord.push_back(stored->data());
+        recordToIndex.reserve(1);
+        recordToIndex.insert(probe, stored);
+        return index;
+    }
 
 public:
-    explicit RecordMap(size_t arity) : arity(arity), indexToRecord(1) {}  // note: index 0 element left free
+    explicit RecordMap(size_t arity, const PagePolicy& policy = defaultPagePolicy(),
+            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : arity(arity), recordToIndex(policy), records(resource),
+              indexToRecord(1, nullptr, policy) {}  // note: index 0 element left free
 
     /** @brief converts record to a record reference */
     // TODO (b-scholz): replace vector<RamDomain> with something more memory-frugal
     RamDomain pack(const std::vector<RamDomain>& vector) {
-        tbb::concurrent_hash_map<std::vector<RamDomain>, RamDomain, RecordHash>::accessor accessor;
-        RamDomain index;
-        if (recordToIndex.find(accessor, vector)) {
-            index = accessor->second;
-        } else {
-            index = static_cast<RamDomain>(indexToRecord.size());
-            recordToIndex.insert(accessor, vector);
-            accessor->second = index;
-            indexToRecord.push_back((&accessor->first)->data());
-
-            // assert that new index is smaller than the range
-            assert(index != std::numeric_limits<RamDomain>::max());
-        }
-        return index;
+        return pack(RecordProbe(vector.data(), vector.size()));
     }
 
     /** @brief convert record pointer to a record reference */
     RamDomain pack(const RamDomain* tuple) {
-        // TODO (b-scholz): data is unnecessarily copied
-        // for a successful lookup. To avoid this, we should
-        // compute a hash of the pointer-array and traverse through
-        // the bucket list of the unordered map finding the record.
-        // Note that in case of non-existence, the record still needs to be
-        // copied for the newly created entry but this will be the less
-        // frequent case.
-        std::vector<RamDomain> tmp(arity);
-        for (size_t i = 0; i < arity; i++) {
-            tmp[i] = tuple[i];
-        }
-        return pack(tmp);
+        return pack(RecordProbe(tuple, arity));
     }
 
     /** @brief convert record reference to a record pointer */
@@ -106,6 +156,12 @@ public:
 class RecordTable {
 public:
     RecordTable() = default;
+
+    /** Create a table allocating the index storage of its record maps according to the given page
+     * policy, and the records from the given resource */
+    explicit RecordTable(
+            const PagePolicy& policy, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : policy(policy), resource(resource) {}
     virtual ~RecordTable() = default;
 
     /** @brief convert record to record reference */
@@ -114,6 +170,18 @@ public:
     }
     /** @brief convert record reference to a record */
     const RamDomain* unpack(RamDomain ref, size_t arity) const {
+        if (arity < smallMaps.size()) {
+            if (const RecordMap* map = smallMaps[arity].load(std::memory_order_acquire)) {
+                return map->unpack(ref);
+            }
+        }
+        return unpackLarge(ref, arity);
+    }
+
+private:
+    /** @brief convert record reference to a record of an arity without a published RecordMap; kept out
+     * of line, such that the accessor does not burden the fast path of unpack */
+    __attribute__((noinline)) const RamDomain* unpackLarge(RamDomain ref, size_t arity) const {
         tbb::concurrent_hash_map<size_t, RecordMap>::const_accessor accessor;
 
         bool result = maps.find(accessor, arity);
@@ -122,19 +190,40 @@ public:
         return (accessor->second).unpack(ref);
     }
 
-private:
     /** @brief lookup RecordMap for a given arity; if it does not exist, create new RecordMap */
     RecordMap& lookupArity(size_t arity) {
+        if (arity < smallMaps.size()) {
+            if (RecordMap* map = smallMaps[arity].load(std::memory_order_acquire)) {
+                return *map;
+            }
+        }
+
         tbb::concurrent_hash_map<size_t, RecordMap>::accessor accessor;
 
-        // This will create a new map if it doesn't exist yet.
-        maps.emplace(accessor, arity, arity);
+        // This will create a new map if it doesn't exist yet; emplace constructs the map before looking
+        // for an existing one, so existing maps are found first.
+        if (!maps.find(accessor, arity)) {
+            maps.emplace(accessor, std::piecewise_construct, std::forward_as_tuple(arity),
+                    std::forward_as_tuple(arity, policy, resource));
+        }
+        if (arity < smallMaps.size()) {
+            smallMaps[arity].store(&accessor->second, std::memory_order_release);
+        }
 
         return accessor->second;
     }
 
     /** Arity/RecordMap association */
     tbb::concurrent_hash_map<size_t, RecordMap> maps;
+
+    /** RecordMaps of small arities, published once created so that finding them does not lock */
+    std::array<std::atomic<RecordMap*>, 16> smallMaps{};
+
+    /** Pages of the index storage of the record maps */
+    PagePolicy policy = defaultPagePolicy();
+
+    /** Resource the records are allocated from */
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource();
 };
 
 /** @brief helper to convert tuple to record reference for the synthesiser */
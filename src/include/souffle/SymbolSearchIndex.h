@@ -0,0 +1,373 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SymbolSearchIndex.h
+ *
+ * Auxiliary index answering prefix and substring queries over the
+ * symbols of a symbol table.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * @class SymbolSearchIndex
+ *
+ * An index over the symbols of a symbol table supporting prefix enumeration and substring matching.
+ *
+ * The index keeps the symbol indices in lexicographic order of their symbols for prefix queries and,
+ * for substring queries, an inverted index from each trigram to the (ascending) indices of the symbols
+ * containing it. Candidates of a substring query are the symbols containing its rarest trigram; they
+ * are verified in parallel.
+ *
+ * The posting lists of the inverted index are compressed: each list is a sequence of gaps between
+ * consecutive indices in variable-length encoding, mostly a byte per gap, and the lists are stored one
+ * after the other in a single buffer, in order of their trigrams. A sorted directory locates the lists.
+ *
+ * The index is built on demand and extended incrementally by update(), which indexes the new symbols
+ * in a segment of their own, i.e., a sorted run and posting lists covering a range of indices, without
+ * touching the existing segments. Segments are merged lazily, whenever the newest is at least half as
+ * large as its predecessor, such that there are logarithmically many and every symbol takes part in
+ * logarithmically many merges. Queries combine the segments: the posting lists of a trigram are
+ * concatenated in order of the segments and the sorted runs are merged. The index must be rebuilt after
+ * the table has been renumbered. Queries may run concurrently with each other, but not with update().
+ */
+class SymbolSearchIndex {
+private:
+    /** The indexed symbol table */
+    const SymbolTable& table;
+
+    /** Number of symbols of the table covered by the index */
+    size_t numIndexed = 0;
+
+    /** The posting list of a trigram, located in the buffer of the encoded gaps */
+    struct PostingList {
+        uint32_t trigram;
+        uint32_t count;
+        /** The last index of the list, from which the gaps of appended indices are taken */
+        RamDomain last;
+        /** Offset of the encoded gaps; they end where the next list starts */
+        size_t offset;
+    };
+
+    /** The index of a range of symbols of the table */
+    struct Segment {
+        /** Indices of the symbols of the segment in lexicographic order of the symbols */
+        std::vector<RamDomain> sorted;
+
+        /** The posting lists in ascending order of their trigrams */
+        std::vector<PostingList> directory;
+
+        /** The encoded gaps of all posting lists, 7 bits per byte with the high bit marking continuation */
+        std::vector<uint8_t> gaps;
+
+        /** Convenience method to find the posting list of a trigram, or nullptr */
+        const PostingList* find(uint32_t t) const {
+            auto pos = std::lower_bound(directory.begin(), directory.end(), t,
+                    [](const PostingList& list, uint32_t trigram) { return list.trigram < trigram; });
+            return (pos == directory.end() || pos->trigram != t) ? nullptr : &*pos;
+        }
+
+        /** The encoded gaps of a posting list of the directory */
+        std::pair<const uint8_t*, const uint8_t*> encoded(const PostingList& list) const {
+            const auto next = static_cast<size_t>(&list - directory.data()) + 1;
+            const size_t end = (next < directory.size()) ? directory[next].offset : gaps.size();
+            return {gaps.data() + list.offset, gaps.data() + end};
+        }
+
+        size_t allocatedBytes() const {
+            return sorted.capacity() * sizeof(RamDomain) + directory.capacity() * sizeof(PostingList) +
+                   gaps.capacity();
+        }
+    };
+
+    /** The segments in ascending order of the indices they cover */
+    std::vector<Segment> segments;
+
+    /** Number of symbols indexed per parallel work item */
+    static constexpr size_t blockSize = 4096;
+
+    static uint32_t trigram(std::string_view str, size_t pos) {
+        return (static_cast<uint32_t>(static_cast<unsigned char>(str[pos])) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(str[pos + 1])) << 8) |
+               static_cast<uint32_t>(static_cast<unsigned char>(str[pos + 2]));
+    }
+
+    /** The distinct trigrams of a string */
+    static std::vector<uint32_t> trigrams(std::string_view str) {
+        std::vector<uint32_t> result;
+        for (size_t pos = 0; pos + 3 <= str.size(); ++pos) {
+            result.push_back(trigram(str, pos));
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+
+    /** Convenience method to append an index to the encoded gaps of a list */
+    static void appendGap(std::vector<uint8_t>& encoded, PostingList& list, RamDomain index) {
+        auto gap = static_cast<uint32_t>(list.count == 0 ? index : index - list.last);
+        while (gap >= 0x80) {
+            encoded.push_back(static_cast<uint8_t>(gap | 0x80));
+            gap >>= 7;
+        }
+        encoded.push_back(static_cast<uint8_t>(gap));
+        list.last = index;
+        ++list.count;
+    }
+
+    /** Convenience method to decode the next gap of a list, advancing the position past it */
+    static uint32_t readGap(const uint8_t*& pos) {
+        uint32_t gap = 0;
+        for (int shift = 0;; shift += 7) {
+            uint8_t byte = *pos++;
+            gap |= static_cast<uint32_t>(byte & 0x7f) << shift;
+            if (byte < 0x80) {
+                return gap;
+            }
+        }
+    }
+
+    /** Convenience method to decode the indices of a posting list of a segment, appending them */
+    static void decode(const Segment& segment, const PostingList& list, std::vector<RamDomain>& result) {
+        const uint8_t* pos = segment.encoded(list).first;
+        RamDomain index = 0;
+        for (uint32_t i = 0; i < list.count; ++i) {
+            const uint32_t gap = readGap(pos);
+            index = (i == 0) ? static_cast<RamDomain>(gap) : index + static_cast<RamDomain>(gap);
+            result.push_back(index);
+        }
+    }
+
+    /** Convenience method to compare two indexed symbols lexicographically */
+    bool less(RamDomain a, RamDomain b) const {
+        return table.unsafeResolve(a) < table.unsafeResolve(b);
+    }
+
+    /** Convenience method to index the symbols of the given range of indices in a new segment */
+    Segment build(size_t first, size_t last) const {
+        Segment segment;
+        segment.sorted.resize(last - first);
+        std::iota(segment.sorted.begin(), segment.sorted.end(), static_cast<RamDomain>(first));
+        std::sort(segment.sorted.begin(), segment.sorted.end(),
+                [&](RamDomain a, RamDomain b) { return less(a, b); });
+
+        // collect the trigrams of the symbols block-wise
+        const size_t numBlocks = (last - first + blockSize - 1) / blockSize;
+        std::vector<std::unordered_map<uint32_t, std::vector<RamDomain>>> blockPostings(numBlocks);
+        parallelFor(0, numBlocks, [&](size_t b) {
+            for (size_t i = first + b * blockSize; i < std::min(last, first + (b + 1) * blockSize); ++i) {
+                for (uint32_t t : trigrams(table.unsafeResolve(static_cast<RamDomain>(i)))) {
+                    blockPostings[b][t].push_back(static_cast<RamDomain>(i));
+                }
+            }
+        });
+        std::vector<uint32_t> found;
+        for (const auto& block : blockPostings) {
+            for (const auto& entry : block) {
+                found.push_back(entry.first);
+            }
+        }
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+
+        // encode the lists in order of their trigrams, appending the indices of the blocks in order
+        segment.directory.reserve(found.size());
+        for (uint32_t t : found) {
+            PostingList list{t, 0, 0, segment.gaps.size()};
+            for (const auto& block : blockPostings) {
+                auto pos = block.find(t);
+                if (pos != block.end()) {
+                    for (RamDomain i : pos->second) {
+                        appendGap(segment.gaps, list, i);
+                    }
+                }
+            }
+            segment.directory.push_back(list);
+        }
+        segment.gaps.shrink_to_fit();
+        return segment;
+    }
+
+    /** Convenience method to merge a segment into the preceding one: the sorted runs are merged, and
+     * lists of the same trigram are concatenated, re-encoding only the first gap of the later list */
+    Segment merge(const Segment& older, const Segment& newer) const {
+        Segment merged;
+        merged.sorted.resize(older.sorted.size() + newer.sorted.size());
+        std::merge(older.sorted.begin(), older.sorted.end(), newer.sorted.begin(), newer.sorted.end(),
+                merged.sorted.begin(), [&](RamDomain a, RamDomain b) { return less(a, b); });
+
+        merged.directory.reserve(older.directory.size() + newer.directory.size());
+        merged.gaps.reserve(older.gaps.size() + newer.gaps.size());
+        auto a = older.directory.begin();
+        auto b = newer.directory.begin();
+        while (a != older.directory.end() || b != newer.directory.end()) {
+            uint32_t t = (a != older.directory.end()) ? a->trigram : b->trigram;
+            if (b != newer.directory.end()) {
+                t = std::min(t, b->trigram);
+            }
+            PostingList list{t, 0, 0, merged.gaps.size()};
+            if (a != older.directory.end() && a->trigram == t) {
+                const auto bytes = older.encoded(*a);
+                merged.gaps.insert(merged.gaps.end(), bytes.first, bytes.second);
+                list.count = a->count;
+                list.last = a->last;
+                ++a;
+            }
+            if (b != newer.directory.end() && b->trigram == t) {
+                auto bytes = newer.encoded(*b);
+                appendGap(merged.gaps, list, static_cast<RamDomain>(readGap(bytes.first)));
+                merged.gaps.insert(merged.gaps.end(), bytes.first, bytes.second);
+                list.count += b->count - 1;
+                list.last = b->last;
+                ++b;
+            }
+            merged.directory.push_back(list);
+        }
+        merged.directory.shrink_to_fit();
+        return merged;
+    }
+
+    /** Select the candidates among the given number of them satisfying the predicate, in parallel, keeping
+     * the order of the candidates; the candidates are obtained by their position */
+    template <typename Candidate, typename Predicate>
+    static std::vector<RamDomain> filter(size_t n, const Candidate& candidate, const Predicate& predicate) {
+        const size_t numBlocks = (n + blockSize - 1) / blockSize;
+        std::vector<std::vector<RamDomain>> matches(numBlocks);
+        parallelFor(0, numBlocks, [&](size_t b) {
+            for (size_t i = b * blockSize; i < std::min(n, (b + 1) * blockSize); ++i) {
+                const RamDomain index = candidate(i);
+                if (predicate(index)) {
+                    matches[b].push_back(index);
+                }
+            }
+        });
+        std::vector<RamDomain> result;
+        for (const auto& block : matches) {
+            result.insert(result.end(), block.begin(), block.end());
+        }
+        return result;
+    }
+
+public:
+    /** Create an index over the current symbols of the given table. */
+    explicit SymbolSearchIndex(const SymbolTable& table) : table(table) {
+        update();
+    }
+
+    /** Extend the index by the symbols added to the table since the last update. */
+    void update() {
+        const size_t first = numIndexed;
+        const size_t last = table.size();
+        if (first == last) {
+            return;
+        }
+        segments.push_back(build(first, last));
+        numIndexed = last;
+
+        // merge the newest segment into its predecessor while they are of a similar size
+        while (segments.size() > 1 &&
+                2 * segments.back().sorted.size() >= segments[segments.size() - 2].sorted.size()) {
+            Segment merged = merge(segments[segments.size() - 2], segments.back());
+            segments.pop_back();
+            segments.back() = std::move(merged);
+        }
+    }
+
+    /** The number of symbols covered by the index */
+    size_t size() const {
+        return numIndexed;
+    }
+
+    /** The number of bytes allocated by the index */
+    size_t allocatedBytes() const {
+        size_t bytes = segments.capacity() * sizeof(Segment);
+        for (const Segment& segment : segments) {
+            bytes += segment.allocatedBytes();
+        }
+        return bytes;
+    }
+
+    /** Enumerate the indices of all indexed symbols starting with the given prefix, in lexicographic
+     * order of the symbols. */
+    std::vector<RamDomain> withPrefix(const std::string& prefix) const {
+        std::vector<RamDomain> result;
+        for (const Segment& segment : segments) {
+            auto first = std::partition_point(segment.sorted.begin(), segment.sorted.end(),
+                    [&](RamDomain i) { return table.unsafeResolve(i) < prefix; });
+            auto last = std::partition_point(first, segment.sorted.end(), [&](RamDomain i) {
+                return table.unsafeResolve(i).compare(0, prefix.size(), prefix) == 0;
+            });
+            const auto middle = static_cast<std::ptrdiff_t>(result.size());
+            result.insert(result.end(), first, last);
+            std::inplace_merge(result.begin(), result.begin() + middle, result.end(),
+                    [&](RamDomain a, RamDomain b) { return less(a, b); });
+        }
+        return result;
+    }
+
+    /** Enumerate the indices of all indexed symbols containing the given string, in ascending order. */
+    std::vector<RamDomain> containing(const std::string& needle) const {
+        auto contains = [&](RamDomain i) {
+            return table.unsafeResolve(i).find(needle) != std::string::npos;
+        };
+
+        // without trigrams to narrow down the candidates, all symbols are verified
+        if (needle.size() < 3) {
+            return filter(
+                    numIndexed, [](size_t i) { return static_cast<RamDomain>(i); }, contains);
+        }
+
+        // otherwise the candidates are the symbols containing the rarest trigram of the needle
+        uint32_t rarest = 0;
+        size_t rarestCount = 0;
+        for (uint32_t t : trigrams(needle)) {
+            size_t count = 0;
+            for (const Segment& segment : segments) {
+                if (const PostingList* list = segment.find(t)) {
+                    count += list->count;
+                }
+            }
+            if (count == 0) {
+                return {};
+            }
+            if (rarestCount == 0 || count < rarestCount) {
+                rarest = t;
+                rarestCount = count;
+            }
+        }
+        std::vector<RamDomain> candidates;
+        candidates.reserve(rarestCount);
+        for (const Segment& segment : segments) {
+            if (const PostingList* list = segment.find(rarest)) {
+                decode(segment, *list, candidates);
+            }
+        }
+        return filter(
+                candidates.size(), [&](size_t i) { return candidates[i]; }, contains);
+    }
+};
+
+}  // namespace souffle
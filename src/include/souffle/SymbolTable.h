@@ -17,20 +17,29 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
+#include "souffle/utility/ArenaAllocator.h"
+#include "souffle/utility/HashUtil.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/OptimisticIndex.h"
+#include "souffle/utility/PageAllocator.h"
 #include "souffle/utility/ParallelUtil.h"
+#include "souffle/utility/SegmentedVector.h"
+#include "souffle/utility/SimdUtil.h"
 #include "souffle/utility/StreamUtil.h"
 #include <algorithm>
+#include <atomic>
 #include <cstdlib>
 #include <deque>
 #include <initializer_list>
 #include <iostream>
+#include <memory_resource>
+#include <new>
+#include <numeric>
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <utility>
 #include <vector>
-#include <tbb/concurrent_vector.h>
-#include <tbb/concurrent_hash_map.h>
 
 namespace souffle {
 
@@ -46,51 +55,249 @@ private:
     /** A lock to synchronize parallel accesses */
     mutable Lock access;
 
-    /** Map indices to string pointers. */
-    tbb::concurrent_vector<const std::string*> numToStr;
+    struct HashedSymbol;
 
-    /** Map strings to indices. */
-    tbb::concurrent_hash_map<std::string, size_t> strToNum;
+    /** A symbol to look up, referenced together with its hash */
+    struct SymbolProbe {
+        std::string_view symbol;
+        size_t hash;
+
+        explicit SymbolProbe(std::string_view symbol) : symbol(symbol), hash(hashString(symbol)) {}
+        SymbolProbe(const HashedSymbol& stored) : symbol(stored.symbol()), hash(stored.hash) {}
+    };
+
+    /** A symbol stored in the table together with its hash, so that resizing the index and rejecting
+     * unequal symbols does not need to touch the characters of the symbol; the characters follow it in
+     * the same allocation, terminated by a null character, and the index is atomic so bulk insertions
+     * can publish it in place */
+    struct HashedSymbol {
+        size_t hash;
+        std::atomic<size_t> index;
+        size_t length;
+
+        HashedSymbol(const SymbolProbe& probe, size_t index)
+                : hash(probe.hash), index(index), length(probe.symbol.size()) {
+            char* characters = reinterpret_cast<char*>(this + 1);
+            probe.symbol.copy(characters, length);
+            characters[length] = '\0';
+        }
+
+        std::string_view symbol() const {
+            return {reinterpret_cast<const char*>(this + 1), length};
+        }
+    };
+
+    /** Hash and equality of stored symbols and probes, used for heterogeneous lookups */
+    struct SymbolHashCompare {
+        using is_transparent = void;
+
+        static size_t hash(const HashedSymbol& symbol) {
+            return symbol.hash;
+        }
+        static size_t hash(const SymbolProbe& probe) {
+            return probe.hash;
+        }
+        static bool equal(const SymbolProbe& a, const HashedSymbol& b) {
+            return a.hash == b.hash && a.symbol == b.symbol();
+        }
+    };
+
+    /** Storage of the stored symbols */
+    Arena symbols;
+
+    /** Map indices to stored symbols; the table owns the stored symbols. */
+    SegmentedVector<const HashedSymbol*> numToStr;
+
+    /** Map symbols to stored symbols; lookups of existing symbols do not write to shared memory, and
+     * inserts are serialized by the lock of the table. */
+    using SymbolMap = OptimisticIndex<HashedSymbol, SymbolHashCompare>;
+    SymbolMap strToNum;
+
+    /** Whether the order of indices matches the lexicographic order of the symbols */
+    std::atomic<bool> ordered{true};
+
+    /** Convenience method to maintain the order flag after symbols from the given index on have been
+     * appended to the table */
+    inline void updateOrdered(size_t from) {
+        if (!ordered.load(std::memory_order_relaxed)) {
+            return;
+        }
+        for (size_t i = std::max<size_t>(from, 1); i < numToStr.size(); ++i) {
+            if (!(numToStr[i - 1]->symbol() < numToStr[i]->symbol())) {
+                ordered.store(false, std::memory_order_relaxed);
+                return;
+            }
+        }
+    }
+
+    /** Convenience method to store a symbol and its characters in the given arena; the storage is
+     * released with the arena */
+    static HashedSymbol* store(Arena& arena, const SymbolProbe& symbol, size_t index) {
+        const size_t bytes = sizeof(HashedSymbol) + symbol.symbol.size() + 1;
+        return new (arena.allocate(bytes, alignof(HashedSymbol))) HashedSymbol(symbol, index);
+    }
+
+    /** Marker of indices reserved by a bulk insertion that are not yet published */
+    static constexpr size_t reserved = size_t(1) << (sizeof(size_t) * 8 - 1);
 
     /** Convenience method to place a new symbol in the table, if it does not exist, and return the index of
      * it; otherwise return the index */
-    inline size_t newSymbolOfIndex(const std::string& symbol) {
-        tbb::concurrent_hash_map<std::string, size_t>::accessor accessor;
-        size_t index;
-        if(strToNum.find(accessor, symbol)) {
-            index = accessor->second;
-        } else {
-            access.lock();
-            if(strToNum.find(accessor, symbol)) {
-                index = accessor->second;
-            } else {
-                index = numToStr.size();
-                strToNum.insert(accessor, symbol);
-                accessor->second = index;
-                numToStr.push_back(&accessor->first);
+    inline size_t newSymbolOfIndex(std::string_view str) {
+        const SymbolProbe symbol(str);
+        if (const HashedSymbol* found = strToNum.find(symbol)) {
+            size_t index = found->index.load(std::memory_order_acquire);
+            if ((index & reserved) == 0) {
+                return index;
             }
-            access.unlock();
         }
+
+        // a reserved symbol gets published once the bulk insertion holding the lock completes
+        auto lease = access.acquire();
+        if (const HashedSymbol* found = strToNum.find(symbol)) {
+            return found->index.load(std::memory_order_relaxed);
+        }
+        size_t index = numToStr.size();
+        auto* stored = store(symbols, symbol, index);
+        numToStr.push_back(stored);
+        strToNum.reserve(1);
+        strToNum.insert(symbol, stored);
+        updateOrdered(index);
         return index;
     }
 
+    /**
+     * Convenience method to intern a sequence of n symbols in parallel, where new symbols receive their
+     * indices in order of their first occurrence in the sequence, independent of thread interleaving.
+     * The functor symbolAt maps positions in the sequence to probes of the symbols.
+     *
+     * The procedure runs in two phases: first, new symbols are inserted with a reserved index holding
+     * their first position in the sequence; second, the owners of the reservations are ranked in
+     * sequence order, a contiguous block of indices is allocated, and all new symbols are published.
+     * Concurrent lookups of existing symbols proceed; lookups of reserved symbols wait for the lock.
+     * The phases run as isolated parallel loops, so that the thread holding the lock does not pick up
+     * unrelated tasks in the meantime that look up symbols themselves.
+     */
+    template <typename SymbolAt>
+    void newSymbolsOfIndices(size_t n, const SymbolAt& symbolAt, RamDomain* result) {
+        // reserved symbol of each occurrence of a new symbol
+        std::vector<HashedSymbol*> claim(n, nullptr);
+
+        auto lease = access.acquire();
+
+        // phase 1: resolve existing symbols; reserve the first position of every new one
+        std::vector<char> missing(n, 0);
+        parallelFor(0, n, [&](size_t i) {
+            if (const HashedSymbol* found = strToNum.find(symbolAt(i))) {
+                result[i] = static_cast<RamDomain>(found->index.load(std::memory_order_relaxed));
+            } else {
+                missing[i] = 1;
+            }
+        });
+        strToNum.reserve(std::count(missing.begin(), missing.end(), 1));
+        parallelFor(0, n, [&](size_t i) {
+            if (missing[i] == 0) return;
+            const auto symbol = symbolAt(i);
+            HashedSymbol* stored = strToNum.find(symbol);
+            if (stored == nullptr) {
+                auto* fresh = store(symbols, symbol, reserved | i);
+                auto inserted = strToNum.insert(symbol, fresh);
+                stored = inserted.first;
+                if (inserted.second) {
+                    claim[i] = stored;
+                    return;
+                }
+                // the storage of the losing symbol stays unused in the arena
+            }
+            size_t position = stored->index.load(std::memory_order_relaxed);
+            while (position > (reserved | i) &&
+                    !stored->index.compare_exchange_weak(position, reserved | i, std::memory_order_relaxed)) {
+            }
+            claim[i] = stored;
+        });
+
+        // phase 2: rank the owners of reservations in input order and allocate a block of indices
+        std::vector<char> owner(n, 0);
+        std::vector<size_t> rank(n);
+        size_t numNew = 0;
+        for (size_t i = 0; i < n; ++i) {
+            rank[i] = numNew;
+            if (claim[i] != nullptr && claim[i]->index.load(std::memory_order_relaxed) == (reserved | i)) {
+                owner[i] = 1;
+                ++numNew;
+            }
+        }
+        if (numNew == 0) {
+            return;
+        }
+        std::vector<const HashedSymbol*> fresh(numNew);
+        parallelFor(0, n, [&](size_t i) {
+            if (owner[i] == 0) return;
+            fresh[rank[i]] = claim[i];
+        });
+
+        // publish the new symbols under their allocated indices; the indices are readable by resolve()
+        // once appended, before the symbols lead to them
+        const size_t base = numToStr.append(fresh.begin(), fresh.end());
+        parallelFor(0, n, [&](size_t i) {
+            if (owner[i] == 0) return;
+            result[i] = static_cast<RamDomain>(base + rank[i]);
+            claim[i]->index.store(base + rank[i], std::memory_order_release);
+        });
+        updateOrdered(base);
+
+        // resolve the remaining occurrences of new symbols
+        parallelFor(0, n, [&](size_t i) {
+            if (claim[i] == nullptr || owner[i] != 0) return;
+            result[i] = static_cast<RamDomain>(claim[i]->index.load(std::memory_order_relaxed));
+        });
+    }
+
+    /** Convenience method to find the first index whose symbol does not satisfy the predicate, given the
+     * predicate holds for a prefix of the (ordered) indices */
+    template <typename Predicate>
+    size_t partitionPoint(const Predicate& predicate) const {
+        size_t first = 0;
+        size_t count = numToStr.size();
+        while (count > 0) {
+            size_t step = count / 2;
+            if (predicate(numToStr[first + step]->symbol())) {
+                first += step + 1;
+                count -= step + 1;
+            } else {
+                count = step;
+            }
+        }
+        return first;
+    }
+
+    /** Convenience method to report order-dependent operations on an unordered table */
+    inline void checkOrdered(const char* operation) const {
+        if (!isOrdered()) {
+            fatal("Error symbol table not ordered in call to `SymbolTable::%s`", operation);
+        }
+    }
+
 public:
     SymbolTable() = default;
 
+    /** Create a table allocating its index storage according to the given page policy, and its symbols
+     * from the given resource */
+    explicit SymbolTable(
+            const PagePolicy& policy, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+            : symbols(resource), numToStr(policy), strToNum(policy) {}
+
     SymbolTable(std::initializer_list<std::string> symbols) {
-        tbb::concurrent_hash_map<std::string, size_t>::accessor accessor;
         for (const auto& symbol : symbols) {
-            strToNum.insert(accessor, symbol);
-            accessor->second = numToStr.size();
-            numToStr.push_back(&accessor->first);
+            newSymbolOfIndex(symbol);
         }
     }
 
     virtual ~SymbolTable() = default;
 
     /** Find the index of a symbol in the table, inserting a new symbol if it does not exist there
-     * already. */
-    RamDomain lookup(const std::string& symbol) {
+     * already. The symbol is only copied if it is new, so it may be a field of an input buffer, see
+     * FieldTokenizer. */
+    RamDomain lookup(std::string_view symbol) {
         {
             return static_cast<RamDomain>(newSymbolOfIndex(symbol));
         }
@@ -98,14 +305,152 @@ public:
 
     /** Find the index of a symbol in the table, inserting a new symbol if it does not exist there
      * already. */
-    RamDomain unsafeLookup(const std::string& symbol) {
+    RamDomain unsafeLookup(std::string_view symbol) {
         return static_cast<RamDomain>(newSymbolOfIndex(symbol));
     }
 
+    /** Find the indices of a sequence of symbols, inserting the symbols that do not exist there already.
+     * The lookups run in parallel; new symbols are numbered in the order of their first occurrence in
+     * the sequence, so the resulting indices do not depend on the number or interleaving of threads. */
+    std::vector<RamDomain> lookupAll(const std::vector<std::string>& symbols) {
+        std::vector<RamDomain> result(symbols.size());
+        newSymbolsOfIndices(
+                symbols.size(), [&](size_t i) { return SymbolProbe(symbols[i]); }, result.data());
+        return result;
+    }
+
+    /** Merge the symbols of another table into this table, numbering new symbols in the order of their
+     * indices in the other table. The result maps indices of the other table to indices of this table.
+     * The other table must not be modified concurrently. */
+    std::vector<RamDomain> merge(const SymbolTable& local) {
+        std::vector<RamDomain> remap(local.size());
+        newSymbolsOfIndices(
+                remap.size(), [&](size_t i) { return SymbolProbe(*local.numToStr[i]); }, remap.data());
+        return remap;
+    }
+
+    /** Merge the symbols of several tables into this table at once, as if they were merged one after the
+     * other in the given order. The result holds one remap vector per table. */
+    std::vector<std::vector<RamDomain>> merge(const std::vector<const SymbolTable*>& locals) {
+        // offsets of the tables in the concatenated sequence of their symbols
+        std::vector<size_t> offsets(locals.size() + 1, 0);
+        for (size_t t = 0; t < locals.size(); ++t) {
+            offsets[t + 1] = offsets[t] + locals[t]->size();
+        }
+        auto symbolAt = [&](size_t i) {
+            size_t t = std::upper_bound(offsets.begin(), offsets.end(), i) - offsets.begin() - 1;
+            return SymbolProbe(*locals[t]->numToStr[i - offsets[t]]);
+        };
+        std::vector<RamDomain> indices(offsets.back());
+        newSymbolsOfIndices(indices.size(), symbolAt, indices.data());
+
+        std::vector<std::vector<RamDomain>> remaps(locals.size());
+        for (size_t t = 0; t < locals.size(); ++t) {
+            remaps[t].assign(indices.begin() + offsets[t], indices.begin() + offsets[t + 1]);
+        }
+        return remaps;
+    }
+
+    /**
+     * Renumber the symbols of the table such that the symbol of index order[k] receives index k, and
+     * rebuild the storage of the symbols in the new order, copying their characters into a fresh arena
+     * such that neighbouring indices have neighbouring characters. The result maps old indices to new ones,
+     * which must be applied to all relations referring to the table, e.g., using remapColumn.
+     *
+     * This is an offline operation; it must not run concurrently with any other access to the table.
+     */
+    std::vector<RamDomain> renumber(const std::vector<RamDomain>& order) {
+        auto lease = access.acquire();
+        if (order.size() != numToStr.size()) {
+            fatal("Error order of size `%d` does not permute `%d` symbols in call to `SymbolTable::renumber`",
+                    order.size(), numToStr.size());
+        }
+
+        // re-insert the symbols in their new order, such that their storage is allocated in that order
+        Arena renumberedSymbols(symbols.upstream_resource());
+        SymbolMap renumbered(strToNum.getPagePolicy());
+        renumbered.reserve(order.size());
+        SegmentedVector<const HashedSymbol*> renumberedNumToStr(numToStr.getPagePolicy());
+        renumberedNumToStr.reserve(order.size());
+        std::vector<RamDomain> remap(order.size());
+        for (size_t k = 0; k < order.size(); ++k) {
+            auto pos = static_cast<size_t>(order[k]);
+            if (pos >= numToStr.size()) {
+                fatal("Error index `%d` out of bounds in call to `SymbolTable::renumber`", pos);
+            }
+            const SymbolProbe symbol(*numToStr[pos]);
+            auto* stored = store(renumberedSymbols, symbol, k);
+            if (!renumbered.insert(symbol, stored).second) {
+                fatal("Error index `%d` repeated in call to `SymbolTable::renumber`", pos);
+            }
+            renumberedNumToStr.push_back(stored);
+            remap[pos] = static_cast<RamDomain>(k);
+        }
+
+        strToNum.swap(renumbered);
+        numToStr.swap(renumberedNumToStr);
+        symbols.swap(renumberedSymbols);
+        ordered.store(true, std::memory_order_relaxed);
+        updateOrdered(0);
+        return remap;
+    }
+
+    /** Rebuild the storage of the symbols in index order without changing any index. */
+    void compact() {
+        std::vector<RamDomain> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        renumber(order);
+    }
+
+    /** Renumber the symbols by descending frequency, where frequency[i] counts the accesses of the
+     * symbol of index i; symbols of equal frequency keep their relative order. */
+    std::vector<RamDomain> renumberByFrequency(const std::vector<size_t>& frequency) {
+        std::vector<RamDomain> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                [&](RamDomain a, RamDomain b) { return frequency[a] > frequency[b]; });
+        return renumber(order);
+    }
+
+    /** Renumber the symbols in lexicographic order of their strings. Afterwards, comparisons of indices
+     * agree with comparisons of the symbols until a symbol is appended out of order; see isOrdered(). */
+    std::vector<RamDomain> renumberSorted() {
+        std::vector<RamDomain> order(size());
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(),
+                [&](RamDomain a, RamDomain b) { return numToStr[a]->symbol() < numToStr[b]->symbol(); });
+        return renumber(order);
+    }
+
+    /** Whether the order of indices matches the lexicographic order of the symbols, i.e., whether
+     * i < j if and only if resolve(i) < resolve(j). This holds after renumberSorted() and as long as
+     * new symbols are appended in increasing order. */
+    bool isOrdered() const {
+        return ordered.load(std::memory_order_relaxed);
+    }
+
+    /** Find the smallest index whose symbol is not less than the given string, or size() if there is
+     * none. Requires an ordered table; see isOrdered(). */
+    RamDomain lowerBound(const std::string& symbol) const {
+        checkOrdered("lowerBound");
+        return static_cast<RamDomain>(partitionPoint([&](std::string_view s) { return s < symbol; }));
+    }
+
+    /** Find the range [first, last) of indices whose symbols start with the given prefix in O(log n).
+     * Requires an ordered table; see isOrdered(). */
+    std::pair<RamDomain, RamDomain> prefixRange(const std::string& prefix) const {
+        checkOrdered("prefixRange");
+        size_t first = partitionPoint([&](std::string_view s) { return s < prefix; });
+        size_t last = partitionPoint(
+                [&](std::string_view s) { return s.compare(0, prefix.size(), prefix) <= 0; });
+        return {static_cast<RamDomain>(first), static_cast<RamDomain>(std::max(first, last))};
+    }
+
     /** Find a symbol in the table by its index, note that this gives an error if the index is out of
-     * bounds.
+     * bounds. The characters are stored in the table and remain valid until the table is renumbered,
+     * compacted or destroyed.
      */
-    const std::string& resolve(const RamDomain index) const {
+    std::string_view resolve(const RamDomain index) const {
         {
             auto pos = static_cast<size_t>(index);
             if (pos >= size()) {
@@ -113,18 +458,40 @@ public:
                 fatal("Error index out of bounds in call to `SymbolTable::resolve`. index = `%d`", index);
             }
             auto result = numToStr[pos];
-            return *result;
+            return result->symbol();
         }
     }
 
-    const std::string& unsafeResolve(const RamDomain index) const {
-        return *numToStr[static_cast<size_t>(index)];
+    std::string_view unsafeResolve(const RamDomain index) const {
+        return numToStr[static_cast<size_t>(index)]->symbol();
     }
 
     /* Return the size of the symbol table, being the number of symbols it currently holds. */
     size_t size() const {
         return numToStr.size();
     }
+
+    /** Return the number of bytes allocated for the symbols and their indices. Must not run concurrently
+     * with inserts. */
+    size_t allocatedBytes() const {
+        return symbols.allocatedBytes() + numToStr.capacity() * sizeof(const HashedSymbol*) +
+               strToNum.allocatedBytes();
+    }
 };
 
+/**
+ * Rewrite a column of n tuples of the given arity, stored consecutively, through a remap vector as
+ * obtained from SymbolTable::merge, i.e., replace each symbol index x in the column by remap[x].
+ */
+inline void remapColumn(
+        RamDomain* tuples, size_t n, size_t arity, size_t column, const std::vector<RamDomain>& remap) {
+    const size_t blockSize = 4096;
+    const size_t numBlocks = (n + blockSize - 1) / blockSize;
+    parallelFor(0, numBlocks, [&](size_t b) {
+        size_t begin = b * blockSize;
+        size_t end = std::min(n, begin + blockSize);
+        simd::gatherRemap(tuples + begin * arity + column, end - begin, arity, remap.data());
+    });
+}
+
 }  // namespace souffle
@@ -0,0 +1,267 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file ArenaAllocator.h
+ *
+ * Memory resources for many small allocations: a monotonic arena and a
+ * pool of size classes cached per thread.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <utility>
+
+namespace souffle {
+
+/**
+ * A monotonic memory resource, allocating by advancing an offset in chunks of growing size obtained
+ * from an upstream resource. Deallocation is a no-op; all memory is returned to the upstream resource
+ * when the arena is released or destroyed.
+ *
+ * Allocations are thread-safe and lock-free while the current chunk has room: a thread claims its
+ * range by a fetch-and-add on the offset of the chunk, and only starting a new chunk takes a lock. A
+ * claim overrunning the chunk is abandoned, so the tail of a chunk may be wasted.
+ */
+class Arena : public std::pmr::memory_resource {
+    struct alignas(std::max_align_t) Chunk {
+        Chunk* previous;
+        std::size_t capacity;
+        std::atomic<std::size_t> used{0};
+
+        Chunk(Chunk* previous, std::size_t capacity) : previous(previous), capacity(capacity) {}
+
+        char* data() {
+            return reinterpret_cast<char*>(this + 1);
+        }
+    };
+
+    /** Size of the first chunk; chunks double in size up to maxChunkSize */
+    static constexpr std::size_t firstChunkSize = std::size_t(1) << 12;
+    static constexpr std::size_t maxChunkSize = std::size_t(1) << 20;
+
+    /** Granularity of allocations, such that each is suitably aligned for any scalar type */
+    static constexpr std::size_t granularity = alignof(std::max_align_t);
+
+    std::pmr::memory_resource* upstream;
+
+    /** The chunk allocations are served from; older chunks are linked from it */
+    std::atomic<Chunk*> current{nullptr};
+
+    /** Lock serializing the start of new chunks */
+    Lock growth;
+
+    /** Convenience method to start a new chunk of room for at least the given size, unless another
+     * thread replaced the exhausted one in the mean-while */
+    void grow(Chunk* exhausted, std::size_t size) {
+        auto lease = growth.acquire();
+        Chunk* last = current.load(std::memory_order_relaxed);
+        if (last != exhausted) {
+            return;
+        }
+        std::size_t capacity = firstChunkSize;
+        if (last != nullptr) {
+            capacity = std::min(2 * last->capacity, maxChunkSize);
+        }
+        capacity = std::max(capacity, size);
+        void* memory = upstream->allocate(sizeof(Chunk) + capacity, alignof(Chunk));
+        current.store(new (memory) Chunk(last, capacity), std::memory_order_release);
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        // round up, such that all claims of a chunk start at a multiple of the granularity
+        std::size_t size = (bytes + granularity - 1) & ~(granularity - 1);
+        if (alignment > granularity) {
+            size += alignment;
+        }
+        while (true) {
+            Chunk* chunk = current.load(std::memory_order_acquire);
+            if (chunk != nullptr) {
+                std::size_t offset = chunk->used.fetch_add(size, std::memory_order_relaxed);
+                if (offset + size <= chunk->capacity) {
+                    auto address = reinterpret_cast<std::uintptr_t>(chunk->data() + offset);
+                    return reinterpret_cast<void*>((address + alignment - 1) & ~(alignment - 1));
+                }
+            }
+            grow(chunk, size);
+        }
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    explicit Arena(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : upstream(upstream) {}
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    ~Arena() override {
+        release();
+    }
+
+    /** The resource the chunks are obtained from */
+    std::pmr::memory_resource* upstream_resource() const {
+        return upstream;
+    }
+
+    /** Number of bytes obtained from the upstream resource */
+    std::size_t allocatedBytes() const {
+        std::size_t bytes = 0;
+        Chunk* chunk = current.load(std::memory_order_acquire);
+        for (; chunk != nullptr; chunk = chunk->previous) {
+            bytes += sizeof(Chunk) + chunk->capacity;
+        }
+        return bytes;
+    }
+
+    /** Returns all chunks to the upstream resource. Must not run concurrently with any other operation. */
+    void release() {
+        Chunk* chunk = current.load(std::memory_order_relaxed);
+        while (chunk != nullptr) {
+            Chunk* previous = chunk->previous;
+            const std::size_t capacity = chunk->capacity;
+            chunk->~Chunk();
+            upstream->deallocate(chunk, sizeof(Chunk) + capacity, alignof(Chunk));
+            chunk = previous;
+        }
+        current.store(nullptr, std::memory_order_relaxed);
+    }
+
+    /** Exchanges the memory of two arenas. Must not run concurrently with any other operation. */
+    void swap(Arena& other) {
+        Chunk* mine = current.load(std::memory_order_relaxed);
+        current.store(other.current.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.current.store(mine, std::memory_order_relaxed);
+        std::swap(upstream, other.upstream);
+    }
+};
+
+/**
+ * A memory resource for small blocks of frequently allocated and released objects.
+ *
+ * Blocks up to maxBlockSize bytes are grouped into size classes, and each thread keeps its own free
+ * list per class, so allocating and releasing a block touches no shared memory. Empty lists are refilled
+ * by carving a batch of blocks from an arena. A released block joins the list of the releasing thread,
+ * which need not be the allocating one; the lists of a terminated thread are taken over by the next
+ * thread claiming its slot. Blocks are only returned to the upstream resource when the pool is
+ * destroyed. Larger blocks are passed through to the upstream resource.
+ */
+class SizeClassPool : public std::pmr::memory_resource {
+public:
+    /** Size classes are multiples of the granularity up to maxBlockSize */
+    static constexpr std::size_t granularity = alignof(std::max_align_t);
+    static constexpr std::size_t numClasses = 16;
+    static constexpr std::size_t maxBlockSize = granularity * numClasses;
+
+private:
+    /** Number of blocks carved from the arena at once */
+    static constexpr std::size_t batchSize = 32;
+
+    struct Block {
+        Block* next;
+    };
+
+    struct alignas(64) Cache {
+        Block* free[numClasses] = {};
+    };
+
+    std::pmr::memory_resource* upstream;
+
+    /** Source of the blocks of all classes */
+    Arena blocks;
+
+    /** The free lists of each thread slot */
+    Cache caches[detail::ThreadSlots::maxThreads];
+
+    /** The free lists of threads without a slot, shared under a lock */
+    Cache shared;
+    Lock sharedAccess;
+
+    static std::size_t sizeClass(std::size_t bytes) {
+        return (std::max<std::size_t>(bytes, 1) - 1) / granularity;
+    }
+
+    /** Convenience method to carve a batch of blocks of a class, returning one and keeping the others */
+    Block* refill(Cache& cache, std::size_t cls) {
+        const std::size_t size = (cls + 1) * granularity;
+        char* batch = static_cast<char*>(blocks.allocate(size * batchSize, granularity));
+        for (std::size_t i = 1; i < batchSize; ++i) {
+            auto* block = reinterpret_cast<Block*>(batch + i * size);
+            block->next = cache.free[cls];
+            cache.free[cls] = block;
+        }
+        return reinterpret_cast<Block*>(batch);
+    }
+
+    /** Convenience method to run an operation on the free lists of the calling thread */
+    template <typename F>
+    auto withCache(const F& operation) {
+        const std::size_t slot = detail::ThreadSlots::local();
+        if (slot < detail::ThreadSlots::maxThreads) {
+            return operation(caches[slot]);
+        }
+        auto lease = sharedAccess.acquire();
+        return operation(shared);
+    }
+
+protected:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        if (bytes > maxBlockSize || alignment > granularity) {
+            return upstream->allocate(bytes, alignment);
+        }
+        const std::size_t cls = sizeClass(bytes);
+        return withCache([&](Cache& cache) -> void* {
+            Block* block = cache.free[cls];
+            if (block == nullptr) {
+                return refill(cache, cls);
+            }
+            cache.free[cls] = block->next;
+            return block;
+        });
+    }
+
+    void do_deallocate(void* pointer, std::size_t bytes, std::size_t alignment) override {
+        if (bytes > maxBlockSize || alignment > granularity) {
+            upstream->deallocate(pointer, bytes, alignment);
+            return;
+        }
+        const std::size_t cls = sizeClass(bytes);
+        withCache([&](Cache& cache) {
+            auto* block = static_cast<Block*>(pointer);
+            block->next = cache.free[cls];
+            cache.free[cls] = block;
+        });
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+public:
+    explicit SizeClassPool(std::pmr::memory_resource* upstream = std::pmr::get_default_resource())
+            : upstream(upstream), blocks(upstream) {}
+
+    SizeClassPool(const SizeClassPool&) = delete;
+    SizeClassPool& operator=(const SizeClassPool&) = delete;
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,169 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file HashUtil.h
+ *
+ * Hash functions for the keys of the symbol and record tables and for
+ * tuples. The vectorized variants are selected at runtime by CPU dispatch.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include "souffle/utility/SimdUtil.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+
+namespace souffle {
+
+namespace detail {
+
+constexpr uint64_t hashPrime1 = 0x9e3779b185ebca87ULL;
+constexpr uint64_t hashPrime2 = 0xc2b2ae3d27d4eb4fULL;
+
+/** Finalizer of MurmurHash3, spreading the entropy of all bits over the whole word */
+inline uint64_t hashMix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t hashLoad(const char* data) {
+    uint64_t word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+inline uint64_t hashLoadTail(const char* data, std::size_t len) {
+    uint64_t word = 0;
+    memcpy(&word, data, len);
+    return word;
+}
+
+inline uint64_t hashRotate(uint64_t h, int bits) {
+    return (h << bits) | (h >> (64 - bits));
+}
+
+/** Portable hash consuming a word per step */
+inline uint64_t hashBytesPortable(const char* data, std::size_t len) {
+    uint64_t h = hashPrime2 ^ (len * hashPrime1);
+    std::size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        h = hashRotate(h ^ (hashLoad(data + i) * hashPrime2), 31) * hashPrime1;
+    }
+    if (i < len) {
+        h = hashRotate(h ^ (hashLoadTail(data + i, len - i) * hashPrime2), 31) * hashPrime1;
+    }
+    return hashMix(h);
+}
+
+#ifdef SOUFFLE_SIMD_X86
+/** Hash based on the CRC32 instruction, consuming 16 bytes per step in two independent streams */
+__attribute__((target("sse4.2"))) inline uint64_t hashBytesSSE42(const char* data, std::size_t len) {
+    uint64_t a = hashPrime1;
+    uint64_t b = len;
+    std::size_t i = 0;
+    for (; i + 16 <= len; i += 16) {
+        a = _mm_crc32_u64(a, hashLoad(data + i));
+        b = _mm_crc32_u64(b, hashLoad(data + i + 8));
+    }
+    if (i + 8 <= len) {
+        a = _mm_crc32_u64(a, hashLoad(data + i));
+        i += 8;
+    }
+    if (i < len) {
+        b = _mm_crc32_u64(b, hashLoadTail(data + i, len - i));
+    }
+    return hashMix((a << 32) ^ b ^ (len * hashPrime2));
+}
+
+/**
+ * Hash consuming 32 bytes per step in four 64 bit lanes; short inputs are left to the CRC32 hash.
+ *
+ * The key of the lanes advances with each block and the accumulator is rotated before each block is
+ * added, so that the hash depends on the order of the blocks, not only on their multiset.
+ */
+__attribute__((target("avx2,sse4.2"))) inline uint64_t hashBytesAVX2(const char* data, std::size_t len) {
+    if (len < 64) {
+        return hashBytesSSE42(data, len);
+    }
+    __m256i acc = _mm256_set_epi64x(hashPrime1, hashPrime2, ~hashPrime1, ~hashPrime2);
+    __m256i secret = _mm256_set_epi64x(0x1cad21f72c81017cULL, 0xdb979083e96dd4deULL,
+            0x7c01812cf721ad1cULL, 0xded46de9839097dbULL);
+    const __m256i step = _mm256_set1_epi64x(hashPrime1);
+    std::size_t i = 0;
+    for (; i + 32 <= len; i += 32) {
+        // accumulate the product of the halves of each keyed lane, and the lane itself
+        __m256i lane = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        __m256i keyed = _mm256_xor_si256(lane, secret);
+        __m256i product = _mm256_mul_epu32(keyed, _mm256_srli_epi64(keyed, 32));
+        __m256i swapped = _mm256_shuffle_epi32(lane, _MM_SHUFFLE(1, 0, 3, 2));
+        acc = _mm256_or_si256(_mm256_slli_epi64(acc, 29), _mm256_srli_epi64(acc, 35));
+        acc = _mm256_add_epi64(acc, _mm256_add_epi64(product, swapped));
+        secret = _mm256_add_epi64(secret, step);
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), acc);
+    uint64_t h = hashMix(lanes[0] ^ hashRotate(lanes[1], 17) ^ hashRotate(lanes[2], 31) ^
+                         hashRotate(lanes[3], 47));
+    return hashMix(h ^ hashBytesSSE42(data + i, len - i) ^ len);
+}
+#endif
+
+using HashKernel = uint64_t (*)(const char*, std::size_t);
+
+/** Select the fastest hash kernel supported by the executing CPU */
+inline HashKernel selectHashKernel() {
+#ifdef SOUFFLE_SIMD_X86
+    if (simd::hasAVX2() && simd::hasSSE42()) {
+        return &hashBytesAVX2;
+    }
+    if (simd::hasSSE42()) {
+        return &hashBytesSSE42;
+    }
+#endif
+    return &hashBytesPortable;
+}
+
+}  // namespace detail
+
+/**
+ * Hashes a sequence of bytes.
+ *
+ * The kernel is selected once per process, so hash values are consistent within a process but
+ * may differ between machines; they must not be persisted.
+ */
+inline std::size_t hashBytes(const void* data, std::size_t len) {
+    static const detail::HashKernel kernel = detail::selectHashKernel();
+    return static_cast<std::size_t>(kernel(static_cast<const char*>(data), len));
+}
+
+/**
+ * Hashes the characters of a string.
+ */
+inline std::size_t hashString(std::string_view str) {
+    return hashBytes(str.data(), str.size());
+}
+
+/**
+ * Hashes an array of n values. Records and tuples of equal content hash to the same value.
+ */
+inline std::size_t hashDomains(const RamDomain* data, std::size_t n) {
+    return hashBytes(data, n * sizeof(RamDomain));
+}
+
+}  // end of namespace souffle
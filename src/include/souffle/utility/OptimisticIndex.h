@@ -0,0 +1,224 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file OptimisticIndex.h
+ *
+ * An open-addressing hash index of entries, read without writing to
+ * shared memory under an optimistic read/write lock.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/PageAllocator.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+/**
+ * A hash index of entries owned by the user of the index, probed by keys of any type supported by
+ * HashCompare (static hash(key), hash(entry) and equal(key, entry), as for tbb::concurrent_hash_map).
+ *
+ * The index maps keys to pointers to entries in an open-addressing table with linear probing. Entries
+ * are never removed, so a slot once filled keeps its entry, and readers probe the table without any
+ * synchronization besides taking a lease of the optimistic lock and validating it afterwards. Only
+ * structural changes, i.e., growing the table, acquire the lock for writing; readers whose lease is
+ * invalidated by a resize retry on the new table. Replaced tables are retired rather than freed, so
+ * readers still probing them access valid memory; they amount to less than the current table.
+ *
+ * Inserts fill slots by compare-and-swap and may run concurrently with each other and with readers,
+ * but not with reserve(); the user of the index has to exclude inserts during a reserve, e.g., by an
+ * insertion lock, and has to reserve capacity before inserting.
+ */
+template <typename Entry, typename HashCompare>
+class OptimisticIndex {
+    struct Table {
+        std::size_t mask;
+        std::atomic<Entry*>* slots;
+
+        Table(std::size_t capacity, const PagePolicy& policy)
+                : mask(capacity - 1),
+                  slots(static_cast<std::atomic<Entry*>*>(
+                          allocatePages(capacity * sizeof(std::atomic<Entry*>), policy))) {
+            for (std::size_t i = 0; i < capacity; ++i) {
+                new (&slots[i]) std::atomic<Entry*>(nullptr);
+            }
+        }
+
+        Table(const Table&) = delete;
+        Table& operator=(const Table&) = delete;
+
+        ~Table() {
+            freePages(slots, (mask + 1) * sizeof(std::atomic<Entry*>));
+        }
+    };
+
+    /** Smallest capacity of a table */
+    static constexpr std::size_t minCapacity = 16;
+
+    /** The current table */
+    std::atomic<Table*> table;
+
+    /** The current table and all retired ones */
+    std::vector<std::unique_ptr<Table>> tables;
+
+    /** Number of entries in the index */
+    std::atomic<std::size_t> count{0};
+
+    /** Lock of the table pointer, written when the table is replaced */
+    mutable OptimisticReadWriteLock lock;
+
+    /** Pages of the tables */
+    PagePolicy policy;
+
+    /** Convenience method to find the entry of a key in the given table, or nullptr */
+    template <typename Key>
+    static Entry* probe(const Table& t, const Key& key, std::size_t hash) {
+        for (std::size_t pos = hash & t.mask;; pos = (pos + 1) & t.mask) {
+            Entry* entry = t.slots[pos].load(std::memory_order_acquire);
+            if (entry == nullptr) {
+                return nullptr;
+            }
+            if (HashCompare::hash(*entry) == hash && HashCompare::equal(key, *entry)) {
+                return entry;
+            }
+        }
+    }
+
+    /** Convenience method to put an entry not yet in the table into its first free slot; the table
+     * must not be accessed concurrently */
+    static void place(Table& t, Entry* entry) {
+        std::size_t pos = HashCompare::hash(*entry) & t.mask;
+        while (t.slots[pos].load(std::memory_order_relaxed) != nullptr) {
+            pos = (pos + 1) & t.mask;
+        }
+        t.slots[pos].store(entry, std::memory_order_relaxed);
+    }
+
+public:
+    explicit OptimisticIndex(const PagePolicy& policy = defaultPagePolicy()) : policy(policy) {
+        tables.emplace_back(new Table(minCapacity, policy));
+        table.store(tables.back().get(), std::memory_order_relaxed);
+    }
+
+    OptimisticIndex(const OptimisticIndex&) = delete;
+    OptimisticIndex& operator=(const OptimisticIndex&) = delete;
+
+    /**
+     * Finds the entry of the given key, or returns nullptr. An entry inserted concurrently may or may
+     * not be found.
+     */
+    template <typename Key>
+    Entry* find(const Key& key) const {
+        const std::size_t hash = HashCompare::hash(key);
+        while (true) {
+            auto lease = lock.start_read();
+            Entry* entry = probe(*table.load(std::memory_order_acquire), key, hash);
+            if (lock.validate(lease)) {
+                return entry;
+            }
+        }
+    }
+
+    /**
+     * Inserts the given entry for its key unless there is an entry of an equal key already. Returns the
+     * entry in the index, and whether it is the given one; otherwise, the caller keeps ownership of the
+     * given entry. Requires capacity reserved for the entry; see reserve().
+     */
+    template <typename Key>
+    std::pair<Entry*, bool> insert(const Key& key, Entry* entry) {
+        const std::size_t hash = HashCompare::hash(key);
+        Table& t = *table.load(std::memory_order_acquire);
+        for (std::size_t pos = hash & t.mask;; pos = (pos + 1) & t.mask) {
+            Entry* occupant = t.slots[pos].load(std::memory_order_acquire);
+            if (occupant == nullptr) {
+                if (t.slots[pos].compare_exchange_strong(
+                            occupant, entry, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    count.fetch_add(1, std::memory_order_relaxed);
+                    return {entry, true};
+                }
+                // another entry was placed here in the mean-while => it may have an equal key
+            }
+            if (HashCompare::hash(*occupant) == hash && HashCompare::equal(key, *occupant)) {
+                return {occupant, false};
+            }
+        }
+    }
+
+    /**
+     * Ensures capacity for the given number of additional entries, keeping the load factor of the
+     * table at most one half. Must not run concurrently with inserts.
+     */
+    void reserve(std::size_t n) {
+        Table* current = table.load(std::memory_order_relaxed);
+        const std::size_t required = 2 * (count.load(std::memory_order_relaxed) + n);
+        if (required <= current->mask + 1) {
+            return;
+        }
+        std::size_t capacity = current->mask + 1;
+        while (capacity < required) {
+            capacity *= 2;
+        }
+
+        lock.start_write();
+        std::unique_ptr<Table> grown(new Table(capacity, policy));
+        for (std::size_t i = 0; i <= current->mask; ++i) {
+            if (Entry* entry = current->slots[i].load(std::memory_order_relaxed)) {
+                place(*grown, entry);
+            }
+        }
+        table.store(grown.get(), std::memory_order_release);
+        tables.push_back(std::move(grown));
+        lock.end_write();
+    }
+
+    /** Page policy of the tables */
+    const PagePolicy& getPagePolicy() const {
+        return policy;
+    }
+
+    /** Number of entries in the index */
+    std::size_t size() const {
+        return count.load(std::memory_order_relaxed);
+    }
+
+    /** Number of bytes of the current table and of the retired ones. Must not run concurrently with
+     * reserve(). */
+    std::size_t allocatedBytes() const {
+        std::size_t bytes = 0;
+        for (const auto& t : tables) {
+            bytes += (t->mask + 1) * sizeof(std::atomic<Entry*>);
+        }
+        return bytes;
+    }
+
+    /**
+     * Exchanges the entries of two indices. Must not run concurrently with any other operation.
+     */
+    void swap(OptimisticIndex& other) {
+        Table* mine = table.load(std::memory_order_relaxed);
+        table.store(other.table.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.table.store(mine, std::memory_order_relaxed);
+        tables.swap(other.tables);
+        std::size_t entries = count.load(std::memory_order_relaxed);
+        count.store(other.count.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.count.store(entries, std::memory_order_relaxed);
+        std::swap(policy, other.policy);
+    }
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,284 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file PageAllocator.h
+ *
+ * Allocation of large arrays of the tables in pages of a selectable
+ * size and NUMA placement.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace souffle {
+
+/**
+ * The pages backing the large arrays of a table, i.e., the segments of its index-to-entry vector and
+ * the slots of its hash index.
+ *
+ * Arrays of at least one huge page are mapped separately and may be backed by transparent huge pages,
+ * requested by madvise, or by explicit huge pages of the reserved pool, falling back to transparent ones
+ * if the pool is exhausted. Their placement on NUMA nodes is either left to the first touch, bound to
+ * the node of the allocating thread, or interleaved across all nodes, such that lookups from any node
+ * cost the same on average. Smaller arrays are allocated by operator new. The policy is a hint: where
+ * the system refuses a part of it, the allocation falls back to transparent huge pages or first-touch
+ * placement, warns once, and appliedPagePolicy() reports the fallback.
+ */
+struct PagePolicy {
+    enum Pages { Normal, Transparent, Explicit };
+    enum Placement { FirstTouch, Local, Interleave };
+
+    Pages pages = Normal;
+    Placement placement = FirstTouch;
+
+    /** Parse a policy given as comma-separated page size and placement, e.g., "transparent",
+     * "explicit,interleave" or "local"; malformed parts are ignored. */
+    static PagePolicy parse(const std::string& str) {
+        PagePolicy policy;
+        for (std::size_t begin = 0; begin < str.size();) {
+            std::size_t end = std::min(str.find(',', begin), str.size());
+            const std::string name = str.substr(begin, end - begin);
+            for (std::size_t i = 0; i < pageNames.size(); ++i) {
+                if (name == pageNames[i]) {
+                    policy.pages = static_cast<Pages>(i);
+                }
+            }
+            for (std::size_t i = 0; i < placementNames.size(); ++i) {
+                if (name == placementNames[i]) {
+                    policy.placement = static_cast<Placement>(i);
+                }
+            }
+            begin = end + 1;
+        }
+        return policy;
+    }
+
+    /** Print a policy in the format accepted by parse() */
+    std::string toString() const {
+        return std::string(pageNames[pages]) + "," + placementNames[placement];
+    }
+
+private:
+    static constexpr std::array<const char*, 3> pageNames = {"normal", "transparent", "explicit"};
+    static constexpr std::array<const char*, 3> placementNames = {"first-touch", "local", "interleave"};
+};
+
+/**
+ * The page policy of tables not given an explicit one, initialized from the environment variable
+ * SOUFFLE_PAGES. Changing it affects tables created afterwards.
+ */
+inline PagePolicy& defaultPagePolicy() {
+    static PagePolicy policy =
+            PagePolicy::parse(std::getenv("SOUFFLE_PAGES") != nullptr ? std::getenv("SOUFFLE_PAGES") : "");
+    return policy;
+}
+
+namespace detail {
+
+/** The parts of the page policies the system refused so far */
+struct PageFallbacks {
+    std::atomic<bool> explicitPages{false};
+    std::atomic<bool> transparentPages{false};
+    std::atomic<bool> placement{false};
+};
+
+inline PageFallbacks& pageFallbacks() {
+    static PageFallbacks fallbacks;
+    return fallbacks;
+}
+
+/** Convenience method to record a fallback, warning when it first occurs */
+inline void fallBack(std::atomic<bool>& fallback, const char* message) {
+    if (!fallback.exchange(true, std::memory_order_relaxed)) {
+        std::cerr << "Warning: " << message << std::endl;
+    }
+}
+
+}  // namespace detail
+
+/**
+ * The page policy as it has been applied to the allocations so far: huge pages and NUMA placements the
+ * system refused for any of them are reported as the fallbacks taken instead. Without the system calls
+ * of Linux, no policy applies.
+ */
+inline PagePolicy appliedPagePolicy(const PagePolicy& requested) {
+    PagePolicy applied;
+#ifdef __linux__
+    applied = requested;
+    const detail::PageFallbacks& fallbacks = detail::pageFallbacks();
+    if (applied.pages == PagePolicy::Explicit && fallbacks.explicitPages.load()) {
+        applied.pages = PagePolicy::Transparent;
+    }
+    if (applied.pages == PagePolicy::Transparent && fallbacks.transparentPages.load()) {
+        applied.pages = PagePolicy::Normal;
+    }
+    if (applied.placement != PagePolicy::FirstTouch && fallbacks.placement.load()) {
+        applied.placement = PagePolicy::FirstTouch;
+    }
+#else
+    (void)requested;
+#endif
+    return applied;
+}
+
+namespace detail {
+
+/** Size of a huge page; arrays of at least this size are mapped separately */
+constexpr std::size_t hugePageSize = std::size_t(1) << 21;
+
+/** Convenience method to round a size up to whole huge pages */
+inline std::size_t roundToHugePages(std::size_t bytes) {
+    return (bytes + hugePageSize - 1) & ~(hugePageSize - 1);
+}
+
+#ifdef __linux__
+/** Convenience method to map a region aligned to huge pages, such that all of it may be backed by
+ * transparent huge pages */
+inline void* mapAligned(std::size_t length) {
+    void* mapped = mmap(nullptr, length + hugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+            -1, 0);
+    if (mapped == MAP_FAILED) {
+        throw std::bad_alloc();
+    }
+    auto begin = reinterpret_cast<std::uintptr_t>(mapped);
+    auto aligned = (begin + hugePageSize - 1) & ~(hugePageSize - 1);
+    // unmap the excess before and after the aligned region
+    if (aligned != begin) {
+        munmap(mapped, aligned - begin);
+    }
+    if (begin + hugePageSize != aligned) {
+        munmap(reinterpret_cast<void*>(aligned + length), begin + hugePageSize - aligned);
+    }
+    return reinterpret_cast<void*>(aligned);
+}
+
+/** The mask of the online NUMA nodes, read once; empty if it is unknown */
+inline const std::vector<unsigned long>& onlineNodes() {
+    static const std::vector<unsigned long> mask = [] {
+        // a list of ranges, e.g., "0-3,6"
+        std::vector<unsigned long> mask;
+        std::ifstream file("/sys/devices/system/node/online");
+        std::string ranges;
+        if (!std::getline(file, ranges)) {
+            return mask;
+        }
+        constexpr std::size_t bits = sizeof(unsigned long) * 8;
+        for (const char* pos = ranges.c_str(); *pos != '\0';) {
+            char* end;
+            std::size_t first = std::strtoul(pos, &end, 10);
+            std::size_t last = *end == '-' ? std::strtoul(end + 1, &end, 10) : first;
+            if (end == pos) {
+                break;
+            }
+            for (std::size_t node = first; node <= last; ++node) {
+                mask.resize(std::max(mask.size(), node / bits + 1), 0);
+                mask[node / bits] |= 1ul << (node % bits);
+            }
+            pos = *end == ',' ? end + 1 : end;
+        }
+        return mask;
+    }();
+    return mask;
+}
+
+/** Convenience method to bind a region to the NUMA nodes of a placement before its first touch, which
+ * places the pages; returns whether the system accepted the binding */
+inline bool placePages(void* region, std::size_t length, PagePolicy::Placement placement) {
+    if (placement == PagePolicy::Local) {
+        return syscall(SYS_mbind, region, length, MPOL_LOCAL, nullptr, 0, 0) == 0;
+    }
+    // interleave across the online nodes only, since a mask of others may be refused
+    const std::vector<unsigned long>& nodes = onlineNodes();
+    if (nodes.empty()) {
+        return false;
+    }
+    // the kernel reads one bit less than the given number of nodes
+    const std::size_t maxNode = nodes.size() * sizeof(unsigned long) * 8 + 1;
+    return syscall(SYS_mbind, region, length, MPOL_INTERLEAVE, nodes.data(), maxNode, 0) == 0;
+}
+#endif
+
+}  // namespace detail
+
+/**
+ * Allocates uninitialized storage of the given size according to a page policy. The storage must be
+ * released by freePages() with the same size, independently of the policy.
+ */
+inline void* allocatePages(std::size_t bytes, const PagePolicy& policy) {
+#ifdef __linux__
+    if (bytes < detail::hugePageSize) {
+        return ::operator new(bytes);
+    }
+    const std::size_t length = detail::roundToHugePages(bytes);
+    void* region = MAP_FAILED;
+    if (policy.pages == PagePolicy::Explicit) {
+        region = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                -1, 0);
+    }
+    if (region == MAP_FAILED) {
+        if (policy.pages == PagePolicy::Explicit) {
+            detail::fallBack(detail::pageFallbacks().explicitPages,
+                    "explicit huge pages are exhausted, using transparent huge pages");
+        }
+        region = detail::mapAligned(length);
+        if (policy.pages != PagePolicy::Normal && madvise(region, length, MADV_HUGEPAGE) != 0) {
+            detail::fallBack(detail::pageFallbacks().transparentPages,
+                    "transparent huge pages are not supported, using normal pages");
+        }
+    }
+
+    if (policy.placement != PagePolicy::FirstTouch && !detail::placePages(region, length, policy.placement)) {
+        detail::fallBack(detail::pageFallbacks().placement,
+                "NUMA placement of pages is not supported, using first-touch placement");
+    }
+    return region;
+#else
+    (void)policy;
+    return ::operator new(bytes);
+#endif
+}
+
+/**
+ * Releases storage allocated by allocatePages() of the given size.
+ */
+inline void freePages(void* region, std::size_t bytes) {
+    if (region == nullptr) {
+        return;
+    }
+#ifdef __linux__
+    if (bytes >= detail::hugePageSize) {
+        munmap(region, detail::roundToHugePages(bytes));
+        return;
+    }
+#endif
+    (void)bytes;
+    ::operator delete(region);
+}
+
+}  // end of namespace souffle
@@ -17,9 +17,67 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
 
+/**
+ * The backend of parallel execution is selected at build time:
+ *  - SOUFFLE_PARALLEL_TBB: TBB parallel algorithms and task groups within a task arena
+ *  - SOUFFLE_PARALLEL_THREADS: the pool of std::threads of the task scheduler
+ *  - otherwise, if compiled with OpenMP: OpenMP
+ *  - otherwise: sequential execution
+ *
+ * Parallel loops written with parallelFor, tasks and sections run on every backend; on the OpenMP
+ * backend, tasks and sections are OpenMP tasks, so that no second pool of threads competes with the
+ * OpenMP team. Parallel regions and pfor loops are OpenMP constructs: each thread of a region runs its
+ * whole body, and OpenMP shares out the iterations of the loop header, which a macro cannot hand to
+ * another backend. Using them with the TBB or threads backend is therefore a compile error rather than a
+ * silently sequential loop.
+ */
+
+#if defined(SOUFFLE_PARALLEL_TBB) || defined(SOUFFLE_PARALLEL_THREADS)
+
+#ifdef SOUFFLE_PARALLEL_TBB
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_group.h>
+#else
+#include <thread>
+#endif
+
+// OpenMP may still be used by the program; nested parallelism is detected through it
 #ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// parallel regions and pfor loops are OpenMP constructs => rejected, see parallelFor
+#define SOUFFLE_OPENMP_ONLY(CONSTRUCT) \
+    static_assert(false, CONSTRUCT " requires the OpenMP backend, use parallelFor instead");
+#define PARALLEL_START SOUFFLE_OPENMP_ONLY("PARALLEL_START") {
+#define PARALLEL_END }
+#define pfor SOUFFLE_OPENMP_ONLY("pfor") for
+#define pfor_static SOUFFLE_OPENMP_ONLY("pfor_static") for
+#define pfor_guided SOUFFLE_OPENMP_ONLY("pfor_guided") for
+#define pfor_dynamic(CHUNK) SOUFFLE_OPENMP_ONLY("pfor_dynamic") for
+#define pfor_runtime SOUFFLE_OPENMP_ONLY("pfor_runtime") for
+
+// section start / end => a scope of tasks on the pooled workers of the task scheduler
+#define SECTIONS_START { ::souffle::TaskScheduler::Scope sectionsScope;
+#define SECTIONS_END }
+
+// the markers for a single section, spawned as a task of the enclosing scope
+#define SECTION_START ::souffle::TaskScheduler::instance().spawn([&]() {
+#define SECTION_END });
+
+#elif defined(_OPENMP)
 
 /**
  * Implementation of parallel control flow constructs utilizing OpenMP
@@ -27,10 +85,6 @@
 
 #include <omp.h>
 
-#ifdef __APPLE__
-#define pthread_yield pthread_yield_np
-#endif
-
 // support for a parallel region
 #define PARALLEL_START _Pragma("omp parallel") {
 #define PARALLEL_END }
@@ -38,26 +92,24 @@
 // support for parallel loops
 #define pfor _Pragma("omp for schedule(dynamic)") for
 
-// spawn and sync are processed sequentially (overhead to expensive)
-#define task_spawn
-#define task_sync
-
-// section start / end => corresponding OpenMP pragmas
-// NOTE: disabled since it causes performance losses
-//#define SECTIONS_START _Pragma("omp parallel sections") {
-// NOTE: we stick to flat-level parallelism since it is faster due to thread pooling
-#define SECTIONS_START {
+// parallel loops of an explicit schedule; pfor_runtime takes it from OMP_SCHEDULE or omp_set_schedule
+#define SOUFFLE_PRAGMA(X) _Pragma(#X)
+#define pfor_static _Pragma("omp for schedule(static)") for
+#define pfor_guided _Pragma("omp for schedule(guided)") for
+#define pfor_dynamic(CHUNK) SOUFFLE_PRAGMA(omp for schedule(dynamic, CHUNK)) for
+#define pfor_runtime _Pragma("omp for schedule(runtime)") for
+
+// section start / end => OpenMP tasks: outside of a parallel region, a team is forked whose single thread
+// spawns the sections while the others run them; within one, the threads are assumed to be busy and the
+// thread of the region runs the sections inline
+// NOTE: "omp parallel sections" is not used since forking nested teams causes performance losses
+#define SECTIONS_START _Pragma("omp parallel if(!omp_in_parallel())") _Pragma("omp single") {
 #define SECTIONS_END }
 
-// the markers for a single section
-//#define SECTION_START _Pragma("omp section") {
-#define SECTION_START {
+// the markers for a single section; like a spawned task, a section refers to the enclosing variables
+#define SECTION_START _Pragma("omp task default(shared)") {
 #define SECTION_END }
 
-// a macro to create an operation context
-#define CREATE_OP_CONTEXT(NAME, INIT) auto NAME = INIT;
-#define READ_OP_CONTEXT(NAME) NAME
-
 #else
 
 // support for a parallel region => sequential execution
@@ -66,9 +118,13 @@
 
 // support for parallel loops => simple sequential loop
 #define pfor for
+#define pfor_static for
+#define pfor_guided for
+#define pfor_dynamic(CHUNK) for
+#define pfor_runtime for
 
-// spawn and sync not supported
-#define task_spawn
+// spawned statements are executed in place, there is nothing to sync
+#define task_spawn(...) { __VA_ARGS__; }
 #define task_sync
 
 // sections are processed sequentially
@@ -79,28 +135,62 @@
 #define SECTION_START {
 #define SECTION_END }
 
-// a macro to create an operation context
-#define CREATE_OP_CONTEXT(NAME, INIT) auto NAME = INIT;
-#define READ_OP_CONTEXT(NAME) NAME
-
 // mark es sequential
 #define IS_SEQUENTIAL
 
 #endif
 
+// a macro to create an operation context
+#define CREATE_OP_CONTEXT(NAME, INIT) auto NAME = INIT;
+#define READ_OP_CONTEXT(NAME) NAME
+
 #ifndef IS_SEQUENTIAL
 #define IS_PARALLEL
+
+// spawn and sync are scheduled by the task scheduler, see TaskScheduler.h;
+// the spawned statement refers to the variables of the spawning frame by reference
+#define task_spawn(...) ::souffle::TaskScheduler::instance().spawn([&]() { __VA_ARGS__; });
+#define task_sync ::souffle::TaskScheduler::instance().sync();
 #endif
 
-#ifdef IS_PARALLEL
+#if defined(SOUFFLE_PARALLEL_TBB)
+#define MAX_THREADS (::souffle::detail::parallelArena().max_concurrency())
+#elif defined(SOUFFLE_PARALLEL_THREADS)
+#define MAX_THREADS (static_cast<int>(std::max(1u, std::thread::hardware_concurrency())))
+#elif defined(IS_PARALLEL)
 #define MAX_THREADS (omp_get_max_threads())
 #else
 #define MAX_THREADS (1)
 #endif
 
+#ifdef SOUFFLE_PARALLEL_TBB
+namespace souffle::detail {
+
+/** The arena running all parallel work of the TBB backend */
+inline tbb::task_arena& parallelArena() {
+    static tbb::task_arena arena;
+    return arena;
+}
+
+}  // namespace souffle::detail
+#endif
+
 #ifdef IS_PARALLEL
 
+#include <climits>
 #include <mutex>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// for code yielding by pthread_yield, on every backend
+#ifdef __APPLE__
+#define pthread_yield pthread_yield_np
+#endif
 
 namespace souffle {
 
@@ -159,31 +249,133 @@ namespace detail {
 #define cpu_relax() asm volatile("" : : : "memory")
 #endif
 
+/**
+ * Counters of the wait operations of all threads.
+ */
+struct WaitCounters {
+    std::atomic<uint64_t> spins{0};
+    std::atomic<uint64_t> parks{0};
+    std::atomic<uint64_t> wakeups{0};
+};
+
+inline WaitCounters& waitCounters() {
+    static WaitCounters counters;
+    return counters;
+}
+
+/**
+ * The number of threads parked on a lock word. Words are mapped to counters by their address,
+ * so words sharing a counter at worst cause unnecessary wakeups.
+ */
+inline std::atomic<int>& parkedOn(const std::atomic<int>& word) {
+    struct alignas(64) Counter {
+        std::atomic<int> parked{0};
+    };
+    static Counter counters[64];
+    auto address = reinterpret_cast<uintptr_t>(&word);
+    return counters[((address >> 6) ^ (address >> 12)) % 64].parked;
+}
+
+/**
+ * Blocks the calling thread while the lock word holds the given value. The thread may also return
+ * spuriously, so the caller has to re-check its condition.
+ */
+inline void park(std::atomic<int>& word, int value) {
+    static_assert(sizeof(std::atomic<int>) == sizeof(int), "a futex is a plain int");
+    std::atomic<int>& parked = parkedOn(word);
+    parked.fetch_add(1, std::memory_order_seq_cst);
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAIT_PRIVATE, value, nullptr, nullptr, 0);
+#else
+    if (word.load(std::memory_order_seq_cst) == value) {
+        std::this_thread::yield();
+    }
+#endif
+    parked.fetch_sub(1, std::memory_order_relaxed);
+    waitCounters().parks.fetch_add(1, std::memory_order_relaxed);
+}
+
+/**
+ * Wakes all threads parked on a lock word. The word has to be modified by a sequentially
+ * consistent operation before, such that a thread about to park either observes the
+ * modification or is observed as parked.
+ */
+inline void unpark(std::atomic<int>& word) {
+    if (parkedOn(word).load(std::memory_order_seq_cst) == 0) {
+        return;
+    }
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<int*>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    waitCounters().wakeups.fetch_add(1, std::memory_order_relaxed);
+}
+
 /**
  * A utility class managing waiting operations for spin locks.
  */
 class Waiter {
     int i = 0;
 
+    /** Number of wait operations spinning before the thread is parked */
+    static constexpr int spinLimit = 1000;
+
 public:
     Waiter() = default;
+    Waiter(const Waiter&) = delete;
+
+    ~Waiter() {
+        if (i > 0) {
+            waitCounters().spins.fetch_add(i, std::memory_order_relaxed);
+        }
+    }
 
     /**
      * Conducts a wait operation.
      */
     void operator()() {
         ++i;
-        if ((i % 1000) == 0) {
+        if ((i % spinLimit) == 0) {
             // there was no progress => let others work
-            pthread_yield();
+            std::this_thread::yield();
         } else {
             // relax this CPU
             cpu_relax();
         }
     }
+
+    /**
+     * Conducts a wait operation for a lock word to change from the observed value. The caller
+     * spins for a while, and is parked on the word once spinning did not pay off; the lock has
+     * to unpark the word whenever it releases a state waited for.
+     */
+    void operator()(std::atomic<int>& word, int observed) {
+        if (i < spinLimit) {
+            ++i;
+            cpu_relax();
+        } else {
+            park(word, observed);
+        }
+    }
 };
 }  // namespace detail
 
+/**
+ * A snapshot of the number of wait operations on locks, for diagnosing contention.
+ */
+struct WaitStatistics {
+    /** Wait operations spinning on the CPU */
+    uint64_t spins;
+    /** Times a thread has been parked */
+    uint64_t parks;
+    /** Wakeups issued to parked threads */
+    uint64_t wakeups;
+};
+
+inline WaitStatistics getWaitStatistics() {
+    const detail::WaitCounters& counters = detail::waitCounters();
+    return {counters.spins.load(), counters.parks.load(), counters.wakeups.load()};
+}
+
 /* compare: http://en.cppreference.com/w/cpp/atomic/atomic_flag */
 class SpinLock {
     std::atomic<int> lck{0};
@@ -208,6 +400,187 @@ public:
     }
 };
 
+namespace detail {
+
+/**
+ * A lease keeping a lock acquired for its life-cycle.
+ */
+template <typename L>
+class LockLease {
+    L* lock;
+
+public:
+    explicit LockLease(L& lock) : lock(&lock) {
+        lock.lock();
+    }
+    LockLease(LockLease&& other) : lock(other.lock) {
+        other.lock = nullptr;
+    }
+    LockLease(const LockLease& other) = delete;
+    ~LockLease() {
+        if (lock != nullptr) {
+            lock->unlock();
+        }
+    }
+};
+
+}  // namespace detail
+
+/**
+ * A queue lock after Mellor-Crummey and Scott (MCS).
+ *
+ * Waiting threads form a queue in which each thread spins on a node of its own, such that the lock
+ * is handed over from thread to thread without any coherence traffic on a shared cache line. Nodes are
+ * taken from a thread-local pool, so the lock offers the interface of Lock; a lock has to be released
+ * by the thread having acquired it.
+ */
+class MCSLock {
+    struct alignas(64) Node {
+        std::atomic<Node*> next{nullptr};
+        std::atomic<bool> locked{false};
+        Node* free = nullptr;
+    };
+
+    /** The nodes of the calling thread not in use by any lock */
+    class NodePool {
+        Node* free = nullptr;
+
+    public:
+        ~NodePool() {
+            while (free != nullptr) {
+                delete std::exchange(free, free->free);
+            }
+        }
+
+        Node* take() {
+            if (free == nullptr) {
+                return new Node();
+            }
+            return std::exchange(free, free->free);
+        }
+
+        void give(Node* node) {
+            node->free = free;
+            free = node;
+        }
+    };
+
+    static NodePool& pool() {
+        static thread_local NodePool nodes;
+        return nodes;
+    }
+
+    /** The last node of the queue */
+    std::atomic<Node*> tail{nullptr};
+
+    /** The node of the owner of the lock; only accessed by the owner */
+    Node* owner = nullptr;
+
+public:
+    using Lease = detail::LockLease<MCSLock>;
+
+    MCSLock() = default;
+
+    // acquired the lock for the live-cycle of the returned guard
+    Lease acquire() {
+        return Lease(*this);
+    }
+
+    void lock() {
+        Node* node = pool().take();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        node->locked.store(true, std::memory_order_relaxed);
+        Node* predecessor = tail.exchange(node, std::memory_order_acq_rel);
+        if (predecessor != nullptr) {
+            predecessor->next.store(node, std::memory_order_release);
+            detail::Waiter wait;
+            while (node->locked.load(std::memory_order_acquire)) {
+                wait();
+            }
+        }
+        owner = node;
+    }
+
+    bool try_lock() {
+        Node* node = pool().take();
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node* expected = nullptr;
+        if (!tail.compare_exchange_strong(expected, node, std::memory_order_acquire, std::memory_order_relaxed)) {
+            pool().give(node);
+            return false;
+        }
+        owner = node;
+        return true;
+    }
+
+    void unlock() {
+        Node* node = owner;
+        Node* successor = node->next.load(std::memory_order_acquire);
+        if (successor == nullptr) {
+            // no known successor => try to empty the queue, otherwise wait for the successor to link in
+            Node* expected = node;
+            if (tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+                pool().give(node);
+                return;
+            }
+            detail::Waiter wait;
+            while ((successor = node->next.load(std::memory_order_acquire)) == nullptr) {
+                wait();
+            }
+        }
+        successor->locked.store(false, std::memory_order_release);
+        pool().give(node);
+    }
+};
+
+/**
+ * A ticket lock with proportional back-off.
+ *
+ * Threads acquire the lock in the order of their tickets. A waiting thread backs off in proportion to
+ * the number of threads ahead of it, so the line holding the ticket being served is polled about once
+ * per hand-over rather than continuously by all waiters.
+ */
+class TicketLock {
+    alignas(64) std::atomic<uint32_t> next{0};
+    alignas(64) std::atomic<uint32_t> serving{0};
+
+    /** Expected number of cycles the lock is held, in pause instructions */
+    static constexpr uint32_t backoffBase = 32;
+
+public:
+    using Lease = detail::LockLease<TicketLock>;
+
+    TicketLock() = default;
+
+    // acquired the lock for the live-cycle of the returned guard
+    Lease acquire() {
+        return Lease(*this);
+    }
+
+    void lock() {
+        const uint32_t ticket = next.fetch_add(1, std::memory_order_relaxed);
+        detail::Waiter wait;
+        uint32_t current;
+        while ((current = serving.load(std::memory_order_acquire)) != ticket) {
+            for (uint32_t i = (ticket - current) * backoffBase; i > 0; --i) {
+                cpu_relax();
+            }
+            wait();
+        }
+    }
+
+    bool try_lock() {
+        uint32_t current = serving.load(std::memory_order_acquire);
+        uint32_t expected = current;
+        return next.compare_exchange_strong(
+                expected, current + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock() {
+        serving.store(serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+};
+
 /**
  * A read/write lock for increased access performance on a
  * read-heavy use case.
@@ -240,17 +613,24 @@ public:
             // release reader
             end_read();
 
-            // wait a bit
-            wait();
+            // wait for the writers to finish
+            r = lck.load(std::memory_order_relaxed);
+            while (r & 0x3) {
+                wait(lck, r);
+                r = lck.load(std::memory_order_relaxed);
+            }
 
             // apply as a reader again
             r = lck.fetch_add(4, std::memory_order_acquire);
 
-        }  // while there is a writer => spin
+        }  // while there is a writer => wait
     }
 
     void end_read() {
-        lck.fetch_sub(4, std::memory_order_release);
+        // the last reader wakes the waiting writer
+        if (lck.fetch_sub(4, std::memory_order_seq_cst) == (4 | 0x2)) {
+            detail::unpark(lck);
+        }
     }
 
     void start_write() {
@@ -259,17 +639,20 @@ public:
         // set wait-for-write bit
         auto stat = lck.fetch_or(2, std::memory_order_acquire);
         while (stat & 0x2) {
-            wait();
+            wait(lck, stat);
             stat = lck.fetch_or(2, std::memory_order_acquire);
         }
 
-        // the caller may starve here ...
+        // the caller may starve here, see PhaseFairReadWriteLock ...
         int should = 2;
         while (!lck.compare_exchange_strong(
-                should, 1, std::memory_order_acquire, std::memory_order_relaxed)) {
-            wait();
+                should, 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            wait(lck, should);
             should = 2;
         }
+
+        // the wait-for-write bit has been released to other writers
+        detail::unpark(lck);
     }
 
     bool try_write() {
@@ -278,7 +661,8 @@ public:
     }
 
     void end_write() {
-        lck.fetch_sub(1, std::memory_order_release);
+        lck.fetch_sub(1, std::memory_order_seq_cst);
+        detail::unpark(lck);
     }
 
     bool try_upgrade_to_write() {
@@ -288,7 +672,380 @@ public:
 
     void downgrade_to_read() {
         // delete write bit + set num readers to 1
-        lck.fetch_add(3, std::memory_order_release);
+        lck.fetch_add(3, std::memory_order_seq_cst);
+        detail::unpark(lck);
+    }
+};
+
+namespace detail {
+
+/**
+ * Slots of per-thread state of concurrent data structures. A thread claims a slot on first use and
+ * releases it when it terminates, such that a later thread may reuse it; a slot is owned by at most one
+ * thread at any time. Threads beyond the number of slots receive none.
+ */
+class ThreadSlots {
+public:
+    /** Number of slots */
+    static constexpr std::size_t maxThreads = 256;
+
+    static ThreadSlots& instance() {
+        static ThreadSlots slots;
+        return slots;
+    }
+
+    /** The slot of the calling thread, or maxThreads if the thread owns no slot */
+    static std::size_t local() {
+        static thread_local Registration registration;
+        return registration.slot;
+    }
+
+    /** Number of slots that have been claimed at any time; slots of higher numbers are unused */
+    std::size_t used() const {
+        return numSlots.load(std::memory_order_acquire);
+    }
+
+private:
+    /** Claims a slot for the life-time of a thread */
+    struct Registration {
+        std::size_t slot;
+
+        Registration() : slot(instance().claim()) {}
+
+        ~Registration() {
+            instance().release(slot);
+        }
+    };
+
+    /** Number of slots that have been claimed at any time */
+    std::atomic<std::size_t> numSlots{0};
+
+    /** The slots released by terminated threads */
+    std::mutex freeMutex;
+    std::vector<std::size_t> freeSlots;
+
+    std::size_t claim() {
+        std::lock_guard<std::mutex> guard(freeMutex);
+        if (!freeSlots.empty()) {
+            std::size_t slot = freeSlots.back();
+            freeSlots.pop_back();
+            return slot;
+        }
+        std::size_t slot = numSlots.load(std::memory_order_relaxed);
+        if (slot < maxThreads) {
+            numSlots.store(slot + 1, std::memory_order_release);
+        }
+        return slot;
+    }
+
+    void release(std::size_t slot) {
+        if (slot < maxThreads) {
+            std::lock_guard<std::mutex> guard(freeMutex);
+            freeSlots.push_back(slot);
+        }
+    }
+};
+
+/**
+ * The reader indicators of biased read/write locks. Each thread owns a cache line of indicators, and
+ * announces a read of a lock by storing the address of the lock in the indicator the lock maps to.
+ * A lock maps to the same indicator in every line, so a writer finds the readers of a lock by
+ * scanning one indicator per thread.
+ */
+class ReaderIndicators {
+public:
+    /** Number of indicators per line */
+    static constexpr std::size_t lineSize = 8;
+
+    using Indicator = std::atomic<const void*>;
+
+    static ReaderIndicators& instance() {
+        static ReaderIndicators indicators;
+        return indicators;
+    }
+
+    /** The indicator of the calling thread for the given lock, or nullptr if the thread owns no line;
+     * threads without a line read through the underlying lock */
+    static Indicator* local(const void* lock) {
+        const std::size_t line = ThreadSlots::local();
+        if (line == ThreadSlots::maxThreads) {
+            return nullptr;
+        }
+        return &instance().lines[line].indicators[position(lock)];
+    }
+
+    /** Tests whether any thread announces a read of the given lock */
+    bool isRead(const void* lock) const {
+        const std::size_t pos = position(lock);
+        const std::size_t used = ThreadSlots::instance().used();
+        for (std::size_t i = 0; i < used; ++i) {
+            if (lines[i].indicators[pos].load(std::memory_order_seq_cst) == lock) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    struct alignas(64) Line {
+        Indicator indicators[lineSize] = {};
+    };
+
+    /** The line of each thread slot */
+    Line lines[ThreadSlots::maxThreads];
+
+    static std::size_t position(const void* lock) {
+        return static_cast<std::size_t>((reinterpret_cast<uintptr_t>(lock) * 0x9e3779b97f4a7c15ULL) >> 61);
+    }
+};
+
+static_assert(ReaderIndicators::lineSize == 8, "a lock is mapped to an indicator by the top 3 bits of its hash");
+
+}  // namespace detail
+
+/**
+ * A reader-biased read/write lock for read-mostly data, after the BRAVO design of Dice and Kogan.
+ *
+ * While the lock is biased towards readers, a reader announces itself in a reader indicator of its own
+ * thread, touching no cache line shared with other readers. A writer revokes the bias and waits for the
+ * announced readers to drain; readers then fall back to an underlying ReadWriteLock. The bias is restored
+ * by a reader once a multiple of the time taken by the last revocation has passed, so revocations cost
+ * writers a bounded fraction of their time.
+ */
+class BiasedReadWriteLock {
+    /** Whether readers may announce themselves in their indicators */
+    std::atomic<bool> readBias{true};
+
+    /** The time before which the bias is not restored, in nanoseconds of the steady clock */
+    std::atomic<int64_t> inhibitUntil{0};
+
+    /** The lock of readers while the bias is revoked, and of writers */
+    ReadWriteLock lock;
+
+    /** Factor of the time taken by a revocation for which the bias stays revoked */
+    static constexpr int64_t inhibitFactor = 9;
+
+    static int64_t now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch())
+                .count();
+    }
+
+    /** Revoke the bias while holding the write lock; returns false if readers remain and wait is false */
+    bool revokeBias(bool wait) {
+        const int64_t start = now();
+        readBias.store(false, std::memory_order_seq_cst);
+        detail::Waiter waiter;
+        bool drained = true;
+        while (detail::ReaderIndicators::instance().isRead(this)) {
+            if (!wait) {
+                drained = false;
+                break;
+            }
+            waiter();
+        }
+        const int64_t end = now();
+        inhibitUntil.store(end + (end - start) * inhibitFactor, std::memory_order_relaxed);
+        return drained;
+    }
+
+public:
+    BiasedReadWriteLock() = default;
+
+    void start_read() {
+        if (readBias.load(std::memory_order_acquire)) {
+            detail::ReaderIndicators::Indicator* indicator = detail::ReaderIndicators::local(this);
+            if (indicator != nullptr && indicator->load(std::memory_order_relaxed) == nullptr) {
+                indicator->store(this, std::memory_order_seq_cst);
+                if (readBias.load(std::memory_order_seq_cst)) {
+                    return;
+                }
+                // the bias has been revoked in the mean-while
+                indicator->store(nullptr, std::memory_order_release);
+            }
+        }
+        lock.start_read();
+        if (!readBias.load(std::memory_order_relaxed) &&
+                now() >= inhibitUntil.load(std::memory_order_relaxed)) {
+            readBias.store(true, std::memory_order_release);
+        }
+    }
+
+    void end_read() {
+        detail::ReaderIndicators::Indicator* indicator = detail::ReaderIndicators::local(this);
+        if (indicator != nullptr && indicator->load(std::memory_order_relaxed) == this) {
+            indicator->store(nullptr, std::memory_order_release);
+            return;
+        }
+        lock.end_read();
+    }
+
+    void start_write() {
+        lock.start_write();
+        if (readBias.load(std::memory_order_relaxed)) {
+            revokeBias(true);
+        }
+    }
+
+    bool try_write() {
+        if (!lock.try_write()) {
+            return false;
+        }
+        if (readBias.load(std::memory_order_relaxed) && !revokeBias(false)) {
+            lock.end_write();
+            return false;
+        }
+        return true;
+    }
+
+    void end_write() {
+        lock.end_write();
+    }
+
+    bool try_upgrade_to_write() {
+        detail::ReaderIndicators::Indicator* indicator = detail::ReaderIndicators::local(this);
+        if (indicator != nullptr && indicator->load(std::memory_order_relaxed) == this) {
+            // an announced reader has to become the only holder of the underlying lock
+            if (!lock.try_write()) {
+                return false;
+            }
+            indicator->store(nullptr, std::memory_order_release);
+        } else if (!lock.try_upgrade_to_write()) {
+            return false;
+        }
+        if (readBias.load(std::memory_order_relaxed) && !revokeBias(false)) {
+            // keep reading through the underlying lock
+            lock.downgrade_to_read();
+            return false;
+        }
+        return true;
+    }
+
+    void downgrade_to_read() {
+        lock.downgrade_to_read();
+    }
+};
+
+/**
+ * A phase-fair read/write lock, the PF-T lock of Brandenburg and Anderson.
+ *
+ * Read and write phases alternate: a waiting writer stops readers arriving after it, and readers
+ * waiting for a writer enter before the next writer. Writers are served in the order of their tickets.
+ * A writer thus waits for at most one read phase per writer ahead of it, and a reader for at most one
+ * write phase, which bounds the latency of both under a continuous load of the other.
+ */
+class PhaseFairReadWriteLock {
+    /**
+     * Layout of the reader words:
+     *      31        ...             8     7 ... 2            1                    0
+     *      +-------------------------+----------------+--------------------+--------------------+
+     *      |       reader count      |     unused     |   writer present   |    writer phase    |
+     *      +-------------------------+----------------+--------------------+--------------------+
+     *
+     * rin counts the readers having entered and holds the state of the writer, rout counts the readers
+     * having left; win and wout are the next ticket to be drawn and served of the writers.
+     */
+    static constexpr int readerIncrement = 0x100;
+    static constexpr int writerBits = 0x3;
+    static constexpr int writerPresent = 0x2;
+    static constexpr int writerPhase = 0x1;
+
+    alignas(64) std::atomic<int> rin{0};
+    alignas(64) std::atomic<int> rout{0};
+    alignas(64) std::atomic<int> win{0};
+    alignas(64) std::atomic<int> wout{0};
+
+    /** Wait for all readers having entered before the given state of rin to leave */
+    void drainReaders(int entered) {
+        detail::Waiter wait;
+        int left = rout.load(std::memory_order_acquire);
+        while (left != entered) {
+            wait(rout, left);
+            left = rout.load(std::memory_order_acquire);
+        }
+    }
+
+    /** Announce a writer of the given ticket to readers, returning the state of rin before */
+    int enterWritePhase(int ticket) {
+        return rin.fetch_add(writerPresent | (ticket & writerPhase), std::memory_order_acquire);
+    }
+
+public:
+    PhaseFairReadWriteLock() = default;
+
+    void start_read() {
+        const int writer = rin.fetch_add(readerIncrement, std::memory_order_acquire) & writerBits;
+        if (writer == 0) {
+            return;
+        }
+        // wait for the write phase of the present writer to end
+        detail::Waiter wait;
+        int r = rin.load(std::memory_order_acquire);
+        while ((r & writerBits) == writer) {
+            wait(rin, r);
+            r = rin.load(std::memory_order_acquire);
+        }
+    }
+
+    void end_read() {
+        rout.fetch_add(readerIncrement, std::memory_order_seq_cst);
+        detail::unpark(rout);
+    }
+
+    void start_write() {
+        const int ticket = win.fetch_add(1, std::memory_order_relaxed);
+        detail::Waiter wait;
+        int served = wout.load(std::memory_order_acquire);
+        while (served != ticket) {
+            wait(wout, served);
+            served = wout.load(std::memory_order_acquire);
+        }
+        drainReaders(enterWritePhase(ticket));
+    }
+
+    bool try_write() {
+        // only if no writer is present or waiting
+        int ticket = wout.load(std::memory_order_acquire);
+        int expected = ticket;
+        if (!win.compare_exchange_strong(expected, ticket + 1, std::memory_order_acquire)) {
+            return false;
+        }
+        if (enterWritePhase(ticket) == rout.load(std::memory_order_acquire)) {
+            return true;
+        }
+        // there are readers => release readers blocked in the mean-while
+        end_write();
+        return false;
+    }
+
+    void end_write() {
+        rin.fetch_and(~writerBits, std::memory_order_seq_cst);
+        detail::unpark(rin);
+        wout.fetch_add(1, std::memory_order_seq_cst);
+        detail::unpark(wout);
+    }
+
+    bool try_upgrade_to_write() {
+        int ticket = wout.load(std::memory_order_acquire);
+        int expected = ticket;
+        if (!win.compare_exchange_strong(expected, ticket + 1, std::memory_order_acquire)) {
+            return false;
+        }
+        // the caller has to be the only reader
+        const auto readers = static_cast<unsigned>(enterWritePhase(ticket)) -
+                             static_cast<unsigned>(rout.load(std::memory_order_acquire));
+        if (readers == readerIncrement) {
+            rout.fetch_add(readerIncrement, std::memory_order_release);
+            return true;
+        }
+        end_write();
+        return false;
+    }
+
+    void downgrade_to_read() {
+        // enter as a reader of the ending write phase
+        rin.fetch_add(readerIncrement, std::memory_order_relaxed);
+        end_write();
     }
 };
 
@@ -337,10 +1094,10 @@ public:
         // get a snapshot of the lease version
         auto v = version.load(std::memory_order_acquire);
 
-        // spin while there is a write in progress
+        // wait while there is a write in progress
         while ((v & 0x1) == 1) {
             // wait for a moment
-            wait();
+            wait(version, v);
             // get an updated version
             v = version.load(std::memory_order_acquire);
         }
@@ -385,7 +1142,7 @@ public:
         // check for concurrent writes
         while ((v & 0x1) == 1) {
             // wait for a moment
-            wait();
+            wait(version, v);
             // get an updated version
             v = version.fetch_or(0x1, std::memory_order_acquire);
         }
@@ -434,7 +1191,8 @@ public:
      */
     void abort_write() {
         // reset version number
-        version.fetch_sub(1, std::memory_order_release);
+        version.fetch_sub(1, std::memory_order_seq_cst);
+        detail::unpark(version);
     }
 
     /**
@@ -443,7 +1201,8 @@ public:
      */
     void end_write() {
         // update version number another time
-        version.fetch_add(1, std::memory_order_release);
+        version.fetch_add(1, std::memory_order_seq_cst);
+        detail::unpark(version);
     }
 
     /**
@@ -465,7 +1224,11 @@ namespace souffle {
  * A small utility class for implementing simple locks.
  */
 struct Lock {
-    class Lease {};
+    class Lease {
+    public:
+        // like its parallel counterpart, a lease is used through its life-cycle only
+        ~Lease() {}
+    };
 
     // no locking if there is no parallel execution
     Lease acquire() {
@@ -481,6 +1244,50 @@ struct Lock {
     void unlock() {}
 };
 
+/**
+ * Without parallel execution, there is no waiting for locks.
+ */
+struct WaitStatistics {
+    uint64_t spins;
+    uint64_t parks;
+    uint64_t wakeups;
+};
+
+inline WaitStatistics getWaitStatistics() {
+    return {0, 0, 0};
+}
+
+/**
+ * Queue and ticket locks are not needed if there is no parallel execution.
+ */
+using MCSLock = Lock;
+using TicketLock = Lock;
+
+namespace detail {
+
+/**
+ * Without parallel execution, there is a single thread slot.
+ */
+class ThreadSlots {
+public:
+    static constexpr std::size_t maxThreads = 1;
+
+    static ThreadSlots& instance() {
+        static ThreadSlots slots;
+        return slots;
+    }
+
+    static std::size_t local() {
+        return 0;
+    }
+
+    std::size_t used() const {
+        return 1;
+    }
+};
+
+}  // namespace detail
+
 /**
  * A 'sequential' non-locking implementation for a spin lock.
  */
@@ -520,6 +1327,9 @@ public:
     void downgrade_to_read() {}
 };
 
+using BiasedReadWriteLock = ReadWriteLock;
+using PhaseFairReadWriteLock = ReadWriteLock;
+
 /**
  * A 'sequential' non-locking implementation for an optimistic r/w lock.
  */
@@ -571,3 +1381,219 @@ inline Lock& getOutputLock() {
 }
 
 }  // end of namespace souffle
+
+#ifdef IS_PARALLEL
+#include "souffle/utility/TaskScheduler.h"
+#endif
+
+namespace souffle {
+
+/**
+ * The schedule of a parallel loop, i.e., how its iterations are split into chunks handed out to threads.
+ *
+ *  - Static: one chunk of equal size per thread
+ *  - Dynamic: chunks of the grain size, each handed out to the next idle thread; a grain size of 0
+ *    yields about four chunks per thread
+ *  - Guided: chunks shrinking with the number of remaining iterations, down to the grain size, each
+ *    handed out to the next idle thread
+ *  - Auto: dynamic, with a grain size derived from the measured cost of the first iterations
+ */
+struct LoopSchedule {
+    enum Kind { Static, Dynamic, Guided, Auto };
+
+    Kind kind = Dynamic;
+    std::size_t grain = 0;
+
+    /** Parse a schedule in the format of OMP_SCHEDULE, e.g., "static", "dynamic,64", "guided,16" or
+     * "auto"; a malformed schedule yields the dynamic schedule of grain size 0. */
+    static LoopSchedule parse(const std::string& str) {
+        static const std::array<const char*, 4> names = {"static", "dynamic", "guided", "auto"};
+        LoopSchedule schedule;
+        const std::string name = str.substr(0, str.find(','));
+        auto pos = std::find(names.begin(), names.end(), name);
+        if (pos == names.end()) {
+            return schedule;
+        }
+        schedule.kind = static_cast<Kind>(pos - names.begin());
+        if (name.size() < str.size()) {
+            schedule.grain = std::strtoul(str.c_str() + name.size() + 1, nullptr, 10);
+        }
+        return schedule;
+    }
+
+    /** Print a schedule in the format of OMP_SCHEDULE */
+    std::string toString() const {
+        static const std::array<const char*, 4> names = {"static", "dynamic", "guided", "auto"};
+        return std::string(names[kind]) + (grain != 0 ? "," + std::to_string(grain) : "");
+    }
+};
+
+/**
+ * The schedule of parallel loops not given an explicit one, initialized from the environment variable
+ * SOUFFLE_SCHEDULE. It may be changed between, but not during, parallel loops.
+ */
+inline LoopSchedule& defaultLoopSchedule() {
+    static LoopSchedule schedule = LoopSchedule::parse(
+            std::getenv("SOUFFLE_SCHEDULE") != nullptr ? std::getenv("SOUFFLE_SCHEDULE") : "");
+    return schedule;
+}
+
+namespace detail {
+
+/** Duration of the first iterations of a loop of auto schedule, measured to derive its grain size */
+constexpr std::chrono::nanoseconds autoSampleTime{20000};
+
+/** Duration of a chunk of a loop of auto schedule */
+constexpr std::chrono::nanoseconds autoChunkTime{50000};
+
+/**
+ * Splits [0, n) into chunks according to a (non-auto) schedule for the given number of threads, returning
+ * the boundaries of the chunks.
+ */
+inline std::vector<std::size_t> splitRange(std::size_t n, const LoopSchedule& schedule, std::size_t threads) {
+    std::vector<std::size_t> bounds = {0};
+    std::size_t grain = schedule.grain;
+    if (schedule.kind == LoopSchedule::Static) {
+        grain = (n + threads - 1) / threads;
+    } else if (grain == 0) {
+        grain = (schedule.kind == LoopSchedule::Guided) ? 1 : (n + 4 * threads - 1) / (4 * threads);
+    }
+    for (std::size_t pos = 0; pos < n;) {
+        std::size_t size = grain;
+        if (schedule.kind == LoopSchedule::Guided) {
+            size = std::max(grain, (n - pos) / (2 * threads));
+        }
+        pos += std::min(size, n - pos);
+        bounds.push_back(pos);
+    }
+    return bounds;
+}
+
+/**
+ * Runs chunk(c) for all c in [0, numChunks) on the threads of the selected backend. Chunks are either
+ * assigned to the threads up front or handed out one at a time to the next idle thread.
+ *
+ * The loop is isolated: while the calling thread waits for its chunks, it does not run unrelated tasks,
+ * which might block on a lock the caller holds.
+ */
+template <typename F>
+void parallelChunks(std::size_t numChunks, const F& chunk, bool assigned) {
+#if defined(SOUFFLE_PARALLEL_TBB)
+    auto body = [&](const tbb::blocked_range<std::size_t>& range) {
+        for (std::size_t c = range.begin(); c != range.end(); ++c) {
+            chunk(c);
+        }
+    };
+    parallelArena().execute([&]() {
+        tbb::this_task_arena::isolate([&]() {
+            tbb::blocked_range<std::size_t> range(0, numChunks, 1);
+            if (assigned) {
+                tbb::parallel_for(range, body, tbb::static_partitioner());
+            } else {
+                tbb::parallel_for(range, body, tbb::simple_partitioner());
+            }
+        });
+    });
+#elif defined(SOUFFLE_PARALLEL_THREADS)
+    // assigned chunks are dealt round-robin to one task per thread, others are spawned one by one
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    const std::size_t numThreads = scheduler.numWorkers() + 1;
+    scheduler.isolate([&]() {
+        TaskScheduler::Scope scope(false);
+        if (assigned) {
+            for (std::size_t t = 0; t < std::min(numThreads, numChunks); ++t) {
+                scheduler.spawn([&chunk, t, numThreads, numChunks]() {
+                    for (std::size_t c = t; c < numChunks; c += numThreads) {
+                        chunk(c);
+                    }
+                });
+            }
+        } else {
+            for (std::size_t c = 0; c < numChunks; ++c) {
+                scheduler.spawn([&chunk, c]() { chunk(c); });
+            }
+        }
+    });
+#elif defined(IS_PARALLEL)
+    if (assigned) {
+#pragma omp parallel for schedule(static, 1)
+        for (std::size_t c = 0; c < numChunks; ++c) {
+            chunk(c);
+        }
+    } else {
+#pragma omp parallel for schedule(dynamic, 1)
+        for (std::size_t c = 0; c < numChunks; ++c) {
+            chunk(c);
+        }
+    }
+#else
+    (void)assigned;
+    for (std::size_t c = 0; c < numChunks; ++c) {
+        chunk(c);
+    }
+#endif
+}
+
+}  // namespace detail
+
+/**
+ * Runs body(i) for all i in [begin, end) in parallel, on any backend, according to the given schedule.
+ *
+ * A loop of auto schedule first runs iterations sequentially for a moment; the remaining iterations are
+ * split into chunks of about 50 microseconds at the measured cost per iteration, or run sequentially if
+ * they fit into a single chunk.
+ */
+template <typename F>
+void parallelFor(std::size_t begin, std::size_t end, const F& body, LoopSchedule schedule) {
+    if (schedule.kind == LoopSchedule::Auto) {
+        const auto start = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds elapsed{0};
+        std::size_t count = 0;
+        while (begin < end && elapsed < detail::autoSampleTime) {
+            body(begin++);
+            ++count;
+            elapsed = std::chrono::steady_clock::now() - start;
+        }
+        if (begin == end) {
+            return;
+        }
+        const auto perIteration = std::max<std::size_t>(1, elapsed.count() / count);
+        schedule.kind = LoopSchedule::Dynamic;
+        schedule.grain = std::max<std::size_t>(
+                {schedule.grain, 1, static_cast<std::size_t>(detail::autoChunkTime.count()) / perIteration});
+        if (end - begin <= schedule.grain) {
+            for (; begin < end; ++begin) {
+                body(begin);
+            }
+            return;
+        }
+    }
+    if (end <= begin) {
+        return;
+    }
+    const auto bounds = detail::splitRange(end - begin, schedule, MAX_THREADS);
+    detail::parallelChunks(
+            bounds.size() - 1,
+            [&](std::size_t c) {
+                for (std::size_t i = begin + bounds[c]; i < begin + bounds[c + 1]; ++i) {
+                    body(i);
+                }
+            },
+            schedule.kind == LoopSchedule::Static);
+}
+
+/**
+ * Runs body(i) for all i in [begin, end) in parallel, on any backend. The iterations are split into chunks
+ * of the given grain size, which are handed out to idle threads; if no grain size is given, the default
+ * schedule is used.
+ */
+template <typename F>
+void parallelFor(std::size_t begin, std::size_t end, const F& body, std::size_t grain = 0) {
+    if (grain == 0) {
+        parallelFor(begin, end, body, defaultLoopSchedule());
+    } else {
+        parallelFor(begin, end, body, LoopSchedule{LoopSchedule::Dynamic, grain});
+    }
+}
+
+}  // end of namespace souffle
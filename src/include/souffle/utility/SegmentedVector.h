@@ -0,0 +1,226 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SegmentedVector.h
+ *
+ * A concurrently growable vector of geometrically sized segments, whose
+ * elements never move.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/utility/PageAllocator.h"
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <thread>
+#include <utility>
+
+namespace souffle {
+
+/**
+ * A vector growing concurrently by segments of doubling size.
+ *
+ * Segment k holds 2^(firstSegmentBits + k) elements, so the segment and the offset of an index are
+ * derived from the position of its highest bit, and an indexed read takes two dependent loads through
+ * a segment table of fixed size. Segments are allocated on demand and their elements are constructed
+ * when they are appended, not when the segment is allocated. Elements never move, so references to
+ * them stay valid while the vector grows. Segments are allocated according to a page policy, see
+ * PagePolicy.
+ *
+ * Appending by push_back(), grow_by() and append() is thread-safe, and so are reads of indices below
+ * size(): an append reserves its indices first, and publishes them once its elements are constructed
+ * and all preceding appends have been published, so size() only counts constructed elements.
+ */
+template <typename T>
+class SegmentedVector {
+    /** The first segment holds 2^firstSegmentBits elements */
+    static constexpr std::size_t firstSegmentBits = 4;
+
+    static constexpr std::size_t numSegments = sizeof(std::size_t) * 8 - firstSegmentBits;
+
+    /** The segments, allocated on demand */
+    std::atomic<T*> segments[numSegments];
+
+    /** Number of indices reserved by appends, including those still constructing their elements */
+    std::atomic<std::size_t> reserved{0};
+
+    /** Number of elements constructed and published, in the order of their reservation */
+    std::atomic<std::size_t> published{0};
+
+    /** Pages of segments allocated from now on */
+    PagePolicy policy;
+
+    /** Convenience method to find the segment of an index */
+    static std::size_t segmentOf(std::size_t index) {
+        std::size_t shifted = index + (std::size_t(1) << firstSegmentBits);
+        return (sizeof(std::size_t) * 8 - 1 - __builtin_clzll(shifted)) - firstSegmentBits;
+    }
+
+    /** Convenience method to find the index of the first element of a segment */
+    static std::size_t segmentBase(std::size_t segment) {
+        return (std::size_t(1) << (segment + firstSegmentBits)) - (std::size_t(1) << firstSegmentBits);
+    }
+
+    static std::size_t segmentSize(std::size_t segment) {
+        return std::size_t(1) << (segment + firstSegmentBits);
+    }
+
+    /** Convenience method to allocate the segments holding the indices of [begin, end) */
+    void allocate(std::size_t begin, std::size_t end) {
+        if (begin >= end) {
+            return;
+        }
+        for (std::size_t k = segmentOf(begin); k <= segmentOf(end - 1); ++k) {
+            if (segments[k].load(std::memory_order_acquire) != nullptr) {
+                continue;
+            }
+            T* segment = static_cast<T*>(allocatePages(segmentSize(k) * sizeof(T), policy));
+            T* expected = nullptr;
+            if (!segments[k].compare_exchange_strong(
+                        expected, segment, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                // another thread allocated the segment in the mean-while
+                freePages(segment, segmentSize(k) * sizeof(T));
+            }
+        }
+    }
+
+    /** Convenience method to append n elements, the i-th one constructed from make(i), returning the
+     * index of the first one */
+    template <typename Make>
+    std::size_t appendBy(std::size_t n, const Make& make) {
+        const std::size_t first = reserved.fetch_add(n, std::memory_order_relaxed);
+        allocate(first, first + n);
+        for (std::size_t i = 0; i < n; ++i) {
+            new (&(*this)[first + i]) T(make(i));
+        }
+        // publish after all preceding appends, such that the published indices form a prefix
+        while (published.load(std::memory_order_acquire) != first) {
+            std::this_thread::yield();
+        }
+        published.store(first + n, std::memory_order_release);
+        return first;
+    }
+
+    /** Convenience method to destroy all elements and free all segments */
+    void release() {
+        const std::size_t n = published.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i) {
+            (*this)[i].~T();
+        }
+        for (std::size_t k = 0; k < numSegments; ++k) {
+            freePages(segments[k].load(std::memory_order_relaxed), segmentSize(k) * sizeof(T));
+            segments[k].store(nullptr, std::memory_order_relaxed);
+        }
+        reserved.store(0, std::memory_order_relaxed);
+        published.store(0, std::memory_order_relaxed);
+    }
+
+public:
+    explicit SegmentedVector(const PagePolicy& policy = defaultPagePolicy()) : policy(policy) {
+        for (auto& segment : segments) {
+            segment.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    explicit SegmentedVector(
+            std::size_t n, const T& value = T(), const PagePolicy& policy = defaultPagePolicy())
+            : SegmentedVector(policy) {
+        grow_by(n, value);
+    }
+
+    SegmentedVector(const SegmentedVector&) = delete;
+    SegmentedVector& operator=(const SegmentedVector&) = delete;
+
+    ~SegmentedVector() {
+        release();
+    }
+
+    T& operator[](std::size_t index) {
+        std::size_t k = segmentOf(index);
+        return segments[k].load(std::memory_order_acquire)[index - segmentBase(k)];
+    }
+
+    const T& operator[](std::size_t index) const {
+        std::size_t k = segmentOf(index);
+        return segments[k].load(std::memory_order_acquire)[index - segmentBase(k)];
+    }
+
+    /** Page policy of the segments */
+    const PagePolicy& getPagePolicy() const {
+        return policy;
+    }
+
+    /** Number of elements appended and published; reads of smaller indices see constructed elements */
+    std::size_t size() const {
+        return published.load(std::memory_order_acquire);
+    }
+
+    bool empty() const {
+        return size() == 0;
+    }
+
+    /** Number of elements the allocated segments hold */
+    std::size_t capacity() const {
+        std::size_t n = 0;
+        for (std::size_t k = 0; k < numSegments; ++k) {
+            if (segments[k].load(std::memory_order_acquire) != nullptr) {
+                n += segmentSize(k);
+            }
+        }
+        return n;
+    }
+
+    /** Allocate the segments for the given number of elements in advance */
+    void reserve(std::size_t n) {
+        allocate(0, n);
+    }
+
+    /** Append an element, returning its index */
+    std::size_t push_back(const T& value) {
+        return grow_by(1, value);
+    }
+
+    /** Append n copies of a value, returning the index of the first one */
+    std::size_t grow_by(std::size_t n, const T& value) {
+        return appendBy(n, [&](std::size_t) -> const T& { return value; });
+    }
+
+    /** Append copies of the elements of [begin, end), returning the index of the first one */
+    template <typename Iterator>
+    std::size_t append(Iterator begin, Iterator end) {
+        return appendBy(static_cast<std::size_t>(end - begin), [&](std::size_t i) -> decltype(auto) {
+            return begin[i];
+        });
+    }
+
+    /** Destroy all elements. Must not run concurrently with any other operation. */
+    void clear() {
+        release();
+    }
+
+    /** Exchange the elements of two vectors. Must not run concurrently with any other operation. */
+    void swap(SegmentedVector& other) {
+        for (std::size_t k = 0; k < numSegments; ++k) {
+            T* mine = segments[k].load(std::memory_order_relaxed);
+            segments[k].store(other.segments[k].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.segments[k].store(mine, std::memory_order_relaxed);
+        }
+        std::size_t n = published.load(std::memory_order_relaxed);
+        reserved.store(other.reserved.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        published.store(other.published.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        other.reserved.store(n, std::memory_order_relaxed);
+        other.published.store(n, std::memory_order_relaxed);
+        std::swap(policy, other.policy);
+    }
+};
+
+}  // end of namespace souffle
@@ -0,0 +1,329 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SimdUtil.h
+ *
+ * Vectorized kernels with a portable fallback. Vector variants are
+ * compiled for their target instruction set and selected at runtime,
+ * so they are available without compiling the whole program for it.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/RamTypes.h"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define SOUFFLE_SIMD_X86
+#include <immintrin.h>
+#endif
+
+namespace souffle {
+
+namespace simd {
+
+/**
+ * Tests whether the executing CPU supports the AVX2 instruction set.
+ */
+inline bool hasAVX2() {
+#ifdef SOUFFLE_SIMD_X86
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Tests whether the executing CPU supports the SSE4.2 instruction set.
+ */
+inline bool hasSSE42() {
+#ifdef SOUFFLE_SIMD_X86
+    static const bool supported = __builtin_cpu_supports("sse4.2");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+namespace detail {
+
+inline void gatherRemapScalar(
+        RamDomain* values, std::size_t n, std::size_t stride, const RamDomain* remap) {
+    for (std::size_t i = 0; i < n; ++i) {
+        values[i * stride] = remap[values[i * stride]];
+    }
+}
+
+#if defined(SOUFFLE_SIMD_X86) && RAM_DOMAIN_SIZE == 32
+__attribute__((target("avx2"))) inline void gatherRemapAVX2(
+        RamDomain* values, std::size_t n, std::size_t stride, const RamDomain* remap) {
+    const auto s = static_cast<int>(stride);
+    const __m256i offsets = _mm256_setr_epi32(0, s, 2 * s, 3 * s, 4 * s, 5 * s, 6 * s, 7 * s);
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        RamDomain* block = values + i * stride;
+        __m256i keys;
+        if (stride == 1) {
+            keys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+        } else {
+            keys = _mm256_i32gather_epi32(block, offsets, 4);
+        }
+        __m256i mapped = _mm256_i32gather_epi32(remap, keys, 4);
+        if (stride == 1) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(block), mapped);
+        } else {
+            // there is no scatter in AVX2
+            alignas(32) RamDomain lanes[8];
+            _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), mapped);
+            for (std::size_t j = 0; j < 8; ++j) {
+                block[j * stride] = lanes[j];
+            }
+        }
+    }
+    gatherRemapScalar(values + i * stride, n - i, stride, remap);
+}
+#endif
+
+}  // namespace detail
+
+/**
+ * Replaces each of n values, stored stride elements apart, by its entry in the remap array,
+ * i.e., values[i * stride] = remap[values[i * stride]].
+ */
+inline void gatherRemap(RamDomain* values, std::size_t n, std::size_t stride, const RamDomain* remap) {
+#if defined(SOUFFLE_SIMD_X86) && RAM_DOMAIN_SIZE == 32
+    // offsets of a strided gather are 32 bit wide
+    if (hasAVX2() && stride * 8 <= static_cast<std::size_t>(MAX_RAM_SIGNED)) {
+        detail::gatherRemapAVX2(values, n, stride, remap);
+        return;
+    }
+#endif
+    detail::gatherRemapScalar(values, n, stride, remap);
+}
+
+namespace detail {
+
+#ifdef SOUFFLE_SIMD_X86
+/** Convenience method to compare the 16 bytes at the given offset of two arrays, storing the position
+ * of the first difference, if any, in result */
+inline bool mismatchBlock(const char* x, const char* y, std::size_t offset, std::size_t& result) {
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(x + offset)),
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(y + offset)));
+    auto mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+    if (mask != 0xffffu) {
+        result = offset + __builtin_ctz(~mask & 0xffffu);
+        return true;
+    }
+    return false;
+}
+
+/** Find the first byte at which two arrays of at least 32 bytes differ; a trailing partial block is
+ * compared overlapping the previous one */
+__attribute__((target("avx2"))) inline std::size_t firstMismatchBytesAVX2(
+        const char* x, const char* y, std::size_t bytes) {
+    std::size_t pos = 0;
+    for (; pos + 32 <= bytes; pos += 32) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + pos)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + pos)));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        if (mask != 0xffffffffu) {
+            return pos + __builtin_ctz(~mask);
+        }
+    }
+    if (pos < bytes) {
+        pos = bytes - 32;
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(x + pos)),
+                _mm256_loadu_si256(reinterpret_cast<const __m256i*>(y + pos)));
+        auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        return mask != 0xffffffffu ? pos + __builtin_ctz(~mask) : bytes;
+    }
+    return bytes;
+}
+
+/** Find the first byte at which two arrays of Bytes >= 16 bytes differ, comparing the given blocks of 16
+ * bytes in order and the partial block overlapping the last one */
+template <std::size_t Bytes, std::size_t... Blocks>
+inline std::size_t firstMismatchBlocks(const char* x, const char* y, std::index_sequence<Blocks...>) {
+    std::size_t result = Bytes;
+    if ((mismatchBlock(x, y, Blocks * 16, result) || ...)) {
+        return result;
+    }
+    if constexpr (Bytes % 16 != 0) {
+        mismatchBlock(x, y, Bytes - 16, result);
+    }
+    return result;
+}
+#endif
+
+/** Find the first byte at which two arrays of the given number of bytes differ, or the number of bytes if
+ * they are equal; a trailing partial block is compared overlapping the previous one */
+inline std::size_t firstMismatchBytes(const char* x, const char* y, std::size_t bytes) {
+    std::size_t pos = 0;
+#ifdef SOUFFLE_SIMD_X86
+    if (bytes >= 32 && hasAVX2()) {
+        return firstMismatchBytesAVX2(x, y, bytes);
+    }
+    std::size_t result = bytes;
+    for (; pos + 16 <= bytes; pos += 16) {
+        if (mismatchBlock(x, y, pos, result)) {
+            return result;
+        }
+    }
+    if (bytes >= 16 && pos < bytes) {
+        mismatchBlock(x, y, bytes - 16, result);
+        return result;
+    }
+#endif
+    for (; pos < bytes; ++pos) {
+        if (x[pos] != y[pos]) {
+            return pos;
+        }
+    }
+    return bytes;
+}
+
+/** Find the first byte at which two arrays of Bytes bytes differ, or Bytes if they are equal */
+template <std::size_t Bytes>
+inline std::size_t firstMismatchBytes(const char* x, const char* y) {
+#ifdef SOUFFLE_SIMD_X86
+    if constexpr (Bytes >= 16) {
+        return firstMismatchBlocks<Bytes>(x, y, std::make_index_sequence<Bytes / 16>());
+    }
+#endif
+    for (std::size_t pos = 0; pos < Bytes; ++pos) {
+        if (x[pos] != y[pos]) {
+            return pos;
+        }
+    }
+    return Bytes;
+}
+
+}  // namespace detail
+
+/**
+ * Finds the first position at which two arrays of n integral values differ, or n if they are equal.
+ *
+ * Blocks of values are compared at once; the first differing value within a block is located
+ * through the mask of equal bytes. SSE2 is part of x86-64, so it needs no dispatch; arrays of at least
+ * 32 bytes are compared in blocks of AVX2 if the executing CPU supports it.
+ */
+template <typename T>
+inline std::size_t firstMismatch(const T* a, const T* b, std::size_t n) {
+    static_assert(std::is_integral_v<T>, "values must be equal exactly if their bytes are equal");
+    return detail::firstMismatchBytes(
+                   reinterpret_cast<const char*>(a), reinterpret_cast<const char*>(b), n * sizeof(T)) /
+           sizeof(T);
+}
+
+/**
+ * Finds the first position at which two arrays of N integral values differ, or N if they are equal.
+ *
+ * The number of values is known at compile time, so the comparison is unrolled into a fixed sequence
+ * of SSE2 blocks and a trailing block placed at compile time, without a loop or a dispatch. These
+ * arrays are tuples of a few blocks, where AVX2 would not pay for its dispatch.
+ */
+template <std::size_t N, typename T>
+inline std::size_t firstMismatch(const T* a, const T* b) {
+    static_assert(std::is_integral_v<T>, "values must be equal exactly if their bytes are equal");
+    return detail::firstMismatchBytes<N * sizeof(T)>(
+                   reinterpret_cast<const char*>(a), reinterpret_cast<const char*>(b)) /
+           sizeof(T);
+}
+
+/**
+ * Tests whether two arrays of n values are equal.
+ */
+inline bool equal(const RamDomain* a, const RamDomain* b, std::size_t n) {
+    return firstMismatch(a, b, n) == n;
+}
+
+namespace detail {
+
+#ifdef SOUFFLE_SIMD_X86
+/** Mask of the 16 bytes starting at s equal to any of the needles */
+template <typename... Chars>
+inline uint32_t matchMask16(const char* s, Chars... needles) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+    __m128i any = _mm_setzero_si128();
+    ((any = _mm_or_si128(any, _mm_cmpeq_epi8(block, _mm_set1_epi8(needles)))), ...);
+    return static_cast<uint32_t>(_mm_movemask_epi8(any));
+}
+
+/** Mask of the 32 bytes starting at s equal to any of the needles */
+template <typename... Chars>
+__attribute__((target("avx2"))) inline uint32_t matchMask32(const char* s, Chars... needles) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+    __m256i any = _mm256_setzero_si256();
+    ((any = _mm256_or_si256(any, _mm256_cmpeq_epi8(block, _mm256_set1_epi8(needles)))), ...);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(any));
+}
+
+/** Find the first of n >= 32 bytes holding one of the needles, or n */
+template <typename... Chars>
+__attribute__((target("avx2"))) inline std::size_t findFirstOfAVX2(
+        const char* s, std::size_t n, Chars... needles) {
+    std::size_t pos = 0;
+    for (; pos + 32 <= n; pos += 32) {
+        if (uint32_t mask = matchMask32(s + pos, needles...)) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    if (pos < n) {
+        uint32_t mask = matchMask32(s + n - 32, needles...);
+        return mask != 0 ? n - 32 + __builtin_ctz(mask) : n;
+    }
+    return n;
+}
+#endif
+
+}  // namespace detail
+
+/**
+ * Finds the first position of n bytes holding one of the given needle characters, or n if there is
+ * none.
+ *
+ * Blocks of bytes are compared with all needles at once, like in firstMismatch, and in blocks of AVX2
+ * if the executing CPU supports it; a trailing partial block is compared overlapping the previous one,
+ * which holds no needle. The needles are broadcast once per call, so they need not be constants.
+ */
+template <typename... Chars>
+inline std::size_t findFirstOf(const char* s, std::size_t n, Chars... needles) {
+    static_assert((std::is_same_v<Chars, char> && ...), "needles must be characters");
+    std::size_t pos = 0;
+#ifdef SOUFFLE_SIMD_X86
+    if (n >= 32 && hasAVX2()) {
+        return detail::findFirstOfAVX2(s, n, needles...);
+    }
+    for (; pos + 16 <= n; pos += 16) {
+        if (uint32_t mask = detail::matchMask16(s + pos, needles...)) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    if (n >= 16 && pos < n) {
+        uint32_t mask = detail::matchMask16(s + n - 16, needles...);
+        return mask != 0 ? n - 16 + __builtin_ctz(mask) : n;
+    }
+#endif
+    for (; pos < n; ++pos) {
+        if (((s[pos] == needles) || ...)) {
+            return pos;
+        }
+    }
+    return n;
+}
+
+}  // namespace simd
+
+}  // end of namespace souffle
@@ -0,0 +1,189 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file SortUtil.h
+ *
+ * Parallel radix sort for arrays of tuples of RAM values.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+namespace detail {
+
+/** Maximal number of bits of a key sorted per pass */
+constexpr std::size_t radixMaxBits = 11;
+
+/** Number of tuples below which a comparison sort is faster */
+constexpr std::size_t radixSortThreshold = 1024;
+
+/** Minimal number of tuples of a chunk sorted by one thread within a pass */
+constexpr std::size_t radixMinChunk = 16384;
+
+/** Map a value to an unsigned key of the same order, flipping the sign bit */
+inline RamUnsigned radixKey(RamDomain value) {
+    return static_cast<RamUnsigned>(value) ^ (RamUnsigned(1) << (RAM_DOMAIN_SIZE - 1));
+}
+
+/** Determine the smallest and the largest key of a column, chunks in parallel */
+template <std::size_t Arity>
+std::pair<RamUnsigned, RamUnsigned> radixKeyRange(
+        const Tuple<RamDomain, Arity>* tuples, std::size_t n, std::size_t numChunks, std::size_t column) {
+    const std::size_t chunkSize = (n + numChunks - 1) / numChunks;
+    std::vector<std::pair<RamUnsigned, RamUnsigned>> ranges(
+            numChunks, {std::numeric_limits<RamUnsigned>::max(), 0});
+    parallelFor(0, numChunks, [&](std::size_t c) {
+        auto& range = ranges[c];
+        for (std::size_t i = c * chunkSize; i < std::min(n, (c + 1) * chunkSize); ++i) {
+            RamUnsigned key = radixKey(tuples[i][column]);
+            range.first = std::min(range.first, key);
+            range.second = std::max(range.second, key);
+        }
+    });
+    std::pair<RamUnsigned, RamUnsigned> result = ranges[0];
+    for (const auto& range : ranges) {
+        result.first = std::min(result.first, range.first);
+        result.second = std::max(result.second, range.second);
+    }
+    return result;
+}
+
+/**
+ * Distribute the tuples of src into dst by one digit of the keys of a column relative to the smallest key,
+ * keeping the relative order of tuples of the same digit.
+ *
+ * The tuples are split into chunks; the digits of each chunk are counted in parallel, the positions of
+ * the buckets of each chunk in dst are derived from all counts, and the chunks are scattered in parallel.
+ */
+template <std::size_t Arity>
+void radixPass(const Tuple<RamDomain, Arity>* src, Tuple<RamDomain, Arity>* dst, std::size_t n,
+        std::size_t numChunks, std::size_t column, RamUnsigned minKey, std::size_t shift, std::size_t bits) {
+    const std::size_t numBuckets = std::size_t(1) << bits;
+    const std::size_t chunkSize = (n + numChunks - 1) / numChunks;
+    auto digit = [&](const Tuple<RamDomain, Arity>& tuple) {
+        return static_cast<std::size_t>((radixKey(tuple[column]) - minKey) >> shift) & (numBuckets - 1);
+    };
+
+    std::vector<std::vector<std::size_t>> offsets(numChunks);
+    parallelFor(0, numChunks, [&](std::size_t c) {
+        std::vector<std::size_t>& counts = offsets[c];
+        counts.assign(numBuckets, 0);
+        for (std::size_t i = c * chunkSize; i < std::min(n, (c + 1) * chunkSize); ++i) {
+            ++counts[digit(src[i])];
+        }
+    });
+
+    // bucket by bucket, chunk by chunk
+    std::size_t pos = 0;
+    for (std::size_t b = 0; b < numBuckets; ++b) {
+        for (std::size_t c = 0; c < numChunks; ++c) {
+            std::size_t count = offsets[c][b];
+            offsets[c][b] = pos;
+            pos += count;
+        }
+    }
+
+    parallelFor(0, numChunks, [&](std::size_t c) {
+        std::size_t* next = offsets[c].data();
+        for (std::size_t i = c * chunkSize; i < std::min(n, (c + 1) * chunkSize); ++i) {
+            dst[next[digit(src[i])]++] = src[i];
+        }
+    });
+}
+
+}  // namespace detail
+
+/**
+ * Sort an array of tuples by a parallel least-significant-digit radix sort.
+ *
+ * Tuples are ordered lexicographically by the given columns, the most significant column first, where
+ * values are compared as signed numbers. Columns that are not given do not take part in the order; the
+ * sort is stable, so tuples equal in the given columns keep their relative order. By default, all
+ * columns are given in their natural order, which yields the order of Tuple::operator<.
+ *
+ * Each column takes as many passes of at most 11 bits as are needed to cover the range of its values,
+ * so columns of few distinct values are cheap to sort. The sort requires a buffer of the size of the array.
+ */
+template <std::size_t Arity>
+void radixSort(Tuple<RamDomain, Arity>* tuples, std::size_t n, std::vector<std::size_t> order = {}) {
+    if (order.empty()) {
+        order.resize(Arity);
+        std::iota(order.begin(), order.end(), 0);
+    }
+    for (std::size_t column : order) {
+        if (column >= Arity) {
+            fatal("Error column out of bounds in call to `radixSort`. column = `%zu`", column);
+        }
+    }
+
+    if (n < detail::radixSortThreshold) {
+        std::stable_sort(tuples, tuples + n, [&](const auto& a, const auto& b) {
+            for (std::size_t column : order) {
+                if (a[column] != b[column]) {
+                    return a[column] < b[column];
+                }
+            }
+            return false;
+        });
+        return;
+    }
+
+    const std::size_t numChunks = std::max<std::size_t>(
+            1, std::min<std::size_t>(4 * MAX_THREADS, n / detail::radixMinChunk));
+    std::vector<Tuple<RamDomain, Arity>> buffer(n);
+    Tuple<RamDomain, Arity>* src = tuples;
+    Tuple<RamDomain, Arity>* dst = buffer.data();
+    for (auto column = order.rbegin(); column != order.rend(); ++column) {
+        // only the bits in which keys differ from the smallest key are sorted, in passes of equal width
+        auto range = detail::radixKeyRange(src, n, numChunks, *column);
+        RamUnsigned span = range.second - range.first;
+        std::size_t bits = 0;
+        while (bits < RAM_DOMAIN_SIZE && (span >> bits) != 0) {
+            ++bits;
+        }
+        std::size_t passes = (bits + detail::radixMaxBits - 1) / detail::radixMaxBits;
+        for (std::size_t pass = 0; pass < passes; ++pass) {
+            std::size_t width = (bits + passes - 1) / passes;
+            detail::radixPass(src, dst, n, numChunks, *column, range.first, pass * width, width);
+            std::swap(src, dst);
+        }
+    }
+
+    if (src != tuples) {
+        const std::size_t chunkSize = (n + numChunks - 1) / numChunks;
+        parallelFor(0, numChunks, [&](std::size_t c) {
+            std::copy(src + std::min(n, c * chunkSize), src + std::min(n, (c + 1) * chunkSize),
+                    tuples + std::min(n, c * chunkSize));
+        });
+    }
+}
+
+/**
+ * Sort a vector of tuples by a parallel radix sort; see above.
+ */
+template <std::size_t Arity>
+void radixSort(std::vector<Tuple<RamDomain, Arity>>& tuples, std::vector<std::size_t> order = {}) {
+    radixSort(tuples.data(), tuples.size(), std::move(order));
+}
+
+}  // end of namespace souffle
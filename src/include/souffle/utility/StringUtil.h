@@ -17,133 +17,202 @@
 #pragma once
 
 #include "souffle/RamTypes.h"
+#include "souffle/utility/SimdUtil.h"
 #include <algorithm>
 #include <cctype>
+#include <charconv>
+#include <cstdint>
 #include <cstdlib>
 #include <fstream>
 #include <limits>
+#include <memory_resource>
 #include <sstream>
 #include <stdexcept>
+#include <system_error>
 #include <string>
+#include <string_view>
 #include <type_traits>
 #include <typeinfo>
 #include <vector>
 
 namespace souffle {
 
-// Forward declaration
-inline bool isPrefix(const std::string& prefix, const std::string& element);
+namespace detail {
+
+/** Convenience method to skip leading white space and a sign, as std::stoll does; returns whether the
+ * sign is a minus */
+inline bool skipSpaceAndSign(const char*& pos, const char* end) {
+    while (pos != end && std::isspace(static_cast<unsigned char>(*pos)) != 0) {
+        ++pos;
+    }
+    if (pos != end && (*pos == '+' || *pos == '-')) {
+        return *pos++ == '-';
+    }
+    return false;
+}
 
 /**
- * Converts a string to a RamSigned
- *
- * This procedure has similar behaviour to std::stoi/stoll.
- *
- * The procedure accepts prefixes 0b (if base = 2) and 0x (if base = 16)
- * If base = 0, the procedure will try to infer the base from the prefix, if present.
+ * Convenience method to parse the digits of an unsigned integer in the given base, where base 0 selects
+ * base 16 for the prefix 0x, base 2 for the prefix 0b, and base 10 otherwise. The prefix 0x (or 0X) is
+ * accepted in base 16 and 0b in base 2; a prefix without digits is read as the number 0 followed by the
+ * letter, as std::stoll does.
  */
-inline RamSigned RamSignedFromString(
-        const std::string& str, std::size_t* position = nullptr, const int base = 10) {
-    RamSigned val;
-
+template <typename T>
+std::from_chars_result parseDigits(const char* pos, const char* end, T& value, int base) {
+    const bool zero = end - pos >= 2 && pos[0] == '0';
+    const bool hexPrefix = zero && (pos[1] == 'x' || (pos[1] == 'X' && base == 16));
+    const bool binaryPrefix = zero && pos[1] == 'b';
     if (base == 0) {
-        if (isPrefix("-0b", str) || isPrefix("0b", str)) {
-            return RamSignedFromString(str, position, 2);
-        } else if (isPrefix("-0x", str) || isPrefix("0x", str)) {
-            return RamSignedFromString(str, position, 16);
-        } else {
-            return RamSignedFromString(str, position);
-        }
+        base = hexPrefix ? 16 : (binaryPrefix ? 2 : 10);
     }
-    std::string binaryNumber;
-    bool parsingBinary = base == 2;
-
-    // stoi/stoll can't handle base 2 prefix by default.
-    if (parsingBinary) {
-        if (isPrefix("-0b", str)) {
-            binaryNumber = "-" + str.substr(3);
-        } else if (isPrefix("0b", str)) {
-            binaryNumber = str.substr(2);
+    if ((base == 16 && hexPrefix) || (base == 2 && binaryPrefix)) {
+        auto result = std::from_chars(pos + 2, end, value, base);
+        if (result.ec != std::errc::invalid_argument) {
+            return result;
         }
+        value = 0;
+        return {pos + 1, std::errc()};
     }
-    const std::string& tmp = parsingBinary ? binaryNumber : str;
+    return std::from_chars(pos, end, value, base);
+}
 
-#if RAM_DOMAIN_SIZE == 64
-    val = std::stoll(tmp, position, base);
-#else
-    val = std::stoi(tmp, position, base);
-#endif
+/** Convenience method to report a failed parse the way std::stoll does */
+inline void checkParsed(const std::from_chars_result& result, const char* function) {
+    if (result.ec == std::errc::invalid_argument) {
+        throw std::invalid_argument(function);
+    }
+    if (result.ec == std::errc::result_out_of_range) {
+        throw std::out_of_range(function);
+    }
+}
+
+}  // namespace detail
 
-    if (parsingBinary && position != nullptr) {
-        *position += 2;
+/**
+ * Parses a RamSigned from the beginning of a string, without allocating or throwing.
+ *
+ * Leading white space and a sign are skipped, as by std::stoll. The prefixes 0b (if base = 2) and 0x
+ * (if base = 16) are accepted; if base = 0, the base is inferred from the prefix, if present, and is 10
+ * otherwise. On success, the result points past the number and value holds it; otherwise, the result
+ * holds std::errc::invalid_argument if there is no number, or std::errc::result_out_of_range if it does
+ * not fit, and value is unchanged.
+ */
+inline std::from_chars_result parseRamSigned(std::string_view str, RamSigned& value, int base = 10) {
+    const char* pos = str.data();
+    const char* end = str.data() + str.size();
+    const bool negative = detail::skipSpaceAndSign(pos, end);
+    uint64_t magnitude = 0;
+    auto result = detail::parseDigits(pos, end, magnitude, base);
+    if (result.ec == std::errc::invalid_argument) {
+        return {str.data(), result.ec};
     }
+    const uint64_t limit = static_cast<uint64_t>(std::numeric_limits<RamSigned>::max()) + (negative ? 1 : 0);
+    if (result.ec != std::errc() || magnitude > limit) {
+        return {result.ptr, std::errc::result_out_of_range};
+    }
+    // negate the magnitude less one, which is representable even for the minimum
+    value = (negative && magnitude != 0) ? -static_cast<RamSigned>(magnitude - 1) - 1
+                                         : static_cast<RamSigned>(magnitude);
+    return result;
+}
 
-    return val;
+/**
+ * Parses a RamUnsigned from the beginning of a string, without allocating or throwing. Unlike
+ * std::stoull, a minus sign is rejected; otherwise, like parseRamSigned.
+ */
+inline std::from_chars_result parseRamUnsigned(std::string_view str, RamUnsigned& value, int base = 10) {
+    const char* pos = str.data();
+    const char* end = str.data() + str.size();
+    if (detail::skipSpaceAndSign(pos, end)) {
+        return {str.data(), std::errc::invalid_argument};
+    }
+    auto result = detail::parseDigits(pos, end, value, base);
+    if (result.ec == std::errc::invalid_argument) {
+        return {str.data(), result.ec};
+    }
+    return result;
 }
 
 /**
- * Converts a string to a RamFloat
+ * Parses a RamFloat from the beginning of a string, without allocating or throwing. Leading white space,
+ * a sign, infinities, NaNs, and hexadecimal numbers of prefix 0x are accepted, as by std::stod;
+ * otherwise, like parseRamSigned.
  */
-inline RamFloat RamFloatFromString(const std::string& str, std::size_t* position = nullptr) {
-    RamFloat val;
-#if RAM_DOMAIN_SIZE == 64
-    val = std::stod(str, position);
-#else
-    val = std::stof(str, position);
-#endif
-    return static_cast<RamFloat>(val);
+inline std::from_chars_result parseRamFloat(std::string_view str, RamFloat& value) {
+    const char* pos = str.data();
+    const char* end = str.data() + str.size();
+    const bool negative = detail::skipSpaceAndSign(pos, end);
+    if (pos != end && (*pos == '+' || *pos == '-')) {
+        return {str.data(), std::errc::invalid_argument};
+    }
+    RamFloat magnitude = 0;
+    std::from_chars_result result;
+    if (end - pos >= 2 && pos[0] == '0' && (pos[1] == 'x' || pos[1] == 'X')) {
+        result = std::from_chars(pos + 2, end, magnitude, std::chars_format::hex);
+        if (result.ec == std::errc::invalid_argument) {
+            result = {pos + 1, std::errc()};
+        }
+    } else {
+        result = std::from_chars(pos, end, magnitude);
+    }
+    if (result.ec == std::errc::invalid_argument) {
+        return {str.data(), result.ec};
+    }
+    if (result.ec == std::errc()) {
+        value = negative ? -magnitude : magnitude;
+    }
+    return result;
 }
+
 /**
- * Converts a string to a RamUnsigned
+ * Converts a string to a RamSigned
  *
- * This procedure has similar behaviour to std::stoul/stoull.
+ * This procedure has similar behaviour to std::stoi/stoll.
  *
  * The procedure accepts prefixes 0b (if base = 2) and 0x (if base = 16)
  * If base = 0, the procedure will try to infer the base from the prefix, if present.
  */
-inline RamUnsigned RamUnsignedFromString(
-        const std::string& str, std::size_t* position = nullptr, const int base = 10) {
-    // Be default C++ (stoul) allows unsigned numbers starting with "-".
-    if (isPrefix("-", str)) {
-        throw std::invalid_argument("Unsigned number can't start with minus.");
-    }
-
-    if (base == 0) {
-        if (isPrefix("0b", str)) {
-            return RamUnsignedFromString(str, position, 2);
-        } else if (isPrefix("0x", str)) {
-            return RamUnsignedFromString(str, position, 16);
-        } else {
-            return RamUnsignedFromString(str, position);
-        }
-    }
-
-    // stoul/stoull can't handle binary prefix by default.
-    std::string binaryNumber;
-    bool parsingBinary = false;
-    if (base == 2 && isPrefix("0b", str)) {
-        binaryNumber = str.substr(2);
-        parsingBinary = true;
+inline RamSigned RamSignedFromString(
+        std::string_view str, std::size_t* position = nullptr, const int base = 10) {
+    RamSigned val = 0;
+    auto result = parseRamSigned(str, val, base);
+    detail::checkParsed(result, "RamSignedFromString");
+    if (position != nullptr) {
+        *position = result.ptr - str.data();
     }
-    const std::string& tmp = parsingBinary ? binaryNumber : str;
-
-    RamUnsigned val;
-#if RAM_DOMAIN_SIZE == 64
-    val = std::stoull(tmp, position, base);
-#else
-    val = std::stoul(tmp, position, base);
-#endif
+    return val;
+}
 
-    if (parsingBinary && position != nullptr) {
-        *position += 2;
+/**
+ * Converts a string to a RamFloat
+ */
+inline RamFloat RamFloatFromString(std::string_view str, std::size_t* position = nullptr) {
+    RamFloat val = 0;
+    auto result = parseRamFloat(str, val);
+    detail::checkParsed(result, "RamFloatFromString");
+    if (position != nullptr) {
+        *position = result.ptr - str.data();
     }
+    return val;
+}
 
-    // check if it's safe to cast (stoul returns unsigned long)
-    if (val > std::numeric_limits<RamUnsigned>::max()) {
-        throw std::invalid_argument("Unsigned number of of bounds");
+/**
+ * Converts a string to a RamUnsigned
+ *
+ * This procedure has similar behaviour to std::stoul/stoull, but rejects a leading minus.
+ *
+ * The procedure accepts prefixes 0b (if base = 2) and 0x (if base = 16)
+ * If base = 0, the procedure will try to infer the base from the prefix, if present.
+ */
+inline RamUnsigned RamUnsignedFromString(
+        std::string_view str, std::size_t* position = nullptr, const int base = 10) {
+    RamUnsigned val = 0;
+    auto result = parseRamUnsigned(str, val, base);
+    detail::checkParsed(result, "RamUnsignedFromString");
+    if (position != nullptr) {
+        *position = result.ptr - str.data();
     }
-
-    return static_cast<RamUnsigned>(val);
+    return val;
 }
 
 /**
@@ -153,16 +222,10 @@ inline RamUnsigned RamUnsignedFromString(
  * Integer can be negative, in all 3 formats this means that it
  * starts with minus (c++ default semantics).
  */
-inline bool canBeParsedAsRamSigned(const std::string& string) {
-    size_t charactersRead = 0;
-
-    try {
-        RamSignedFromString(string, &charactersRead, 0);
-    } catch (...) {
-        return false;
-    }
-
-    return charactersRead == string.size();
+inline bool canBeParsedAsRamSigned(std::string_view string) {
+    RamSigned val;
+    auto result = parseRamSigned(string, val, 0);
+    return result.ec == std::errc() && result.ptr == string.data() + string.size();
 }
 
 /**
@@ -170,27 +233,19 @@ inline bool canBeParsedAsRamSigned(const std::string& string) {
  *
  * Souffle accepts: hex, binary and base 10.
  */
-inline bool canBeParsedAsRamUnsigned(const std::string& string) {
-    size_t charactersRead = 0;
-    try {
-        RamUnsignedFromString(string, &charactersRead, 0);
-    } catch (...) {
-        return false;
-    }
-    return charactersRead == string.size();
+inline bool canBeParsedAsRamUnsigned(std::string_view string) {
+    RamUnsigned val;
+    auto result = parseRamUnsigned(string, val, 0);
+    return result.ec == std::errc() && result.ptr == string.data() + string.size();
 }
 
 /**
  * Can a string be parsed as RamFloat.
  */
-inline bool canBeParsedAsRamFloat(const std::string& string) {
-    size_t charactersRead = 0;
-    try {
-        RamFloatFromString(string, &charactersRead);
-    } catch (...) {
-        return false;
-    }
-    return charactersRead == string.size();
+inline bool canBeParsedAsRamFloat(std::string_view string) {
+    RamFloat val;
+    auto result = parseRamFloat(string, val);
+    return result.ec == std::errc() && result.ptr == string.data() + string.size();
 }
 
 #if RAM_DOMAIN_SIZE == 64
@@ -309,55 +364,68 @@ inline bool endsWith(const std::string& value, const std::string& ending) {
     return std::equal(ending.rbegin(), ending.rend(), value.rbegin());
 }
 
+namespace detail {
+
 /**
- * Splits a string given a delimiter
+ * Convenience method to append a string to a sink, replacing each of the given special characters by
+ * the sequence returned for it by replace. Characters between specials are appended in bulk, and the
+ * specials are located a block of bytes at a time, see simd::findFirstOf.
  */
-inline std::vector<std::string> splitString(const std::string& str, char delimiter) {
-    std::vector<std::string> parts;
-    std::stringstream strstr(str);
-    std::string token;
-    while (std::getline(strstr, token, delimiter)) {
-        parts.push_back(token);
+template <char... Specials, typename Replace>
+void appendReplaced(std::string_view input, std::string& out, const Replace& replace) {
+    for (std::size_t pos = 0; pos < input.size();) {
+        std::size_t next = pos + simd::findFirstOf(input.data() + pos, input.size() - pos, Specials...);
+        out.append(input.data() + pos, next - pos);
+        if (next == input.size()) {
+            break;
+        }
+        out.append(replace(input[next]));
+        pos = next + 1;
     }
-    return parts;
+}
+
+/** Convenience method to replace all non-overlapping occurrences of a needle, from left to right */
+inline std::string replaceAll(
+        const std::string& input, const std::string& needle, const std::string& replacement) {
+    if (needle.empty()) {
+        return input;
+    }
+    std::string result;
+    result.reserve(input.size());
+    std::size_t pos = 0;
+    for (std::size_t next; (next = input.find(needle, pos)) != std::string::npos;) {
+        result.append(input, pos, next - pos);
+        result.append(replacement);
+        pos = next + needle.size();
+    }
+    result.append(input, pos, std::string::npos);
+    return result;
+}
+
+}  // namespace detail
+
+/**
+ * Append a string to a sink using escapes for escape, newline, tab, double-quotes and semicolons
+ */
+inline void stringify(std::string_view input, std::string& out) {
+    detail::appendReplaced<'\\', ';', '"', '\n', '\t'>(input, out, [](char c) -> std::string_view {
+        switch (c) {
+            case '\\': return "\\\\";
+            case ';': return "\\;";
+            case '"': return "\\\"";
+            case '\n': return "\\n";
+            default: return "\\t";
+        }
+    });
 }
 
 /**
  * Stringify a string using escapes for escape, newline, tab, double-quotes and semicolons
  */
 inline std::string stringify(const std::string& input) {
-    std::string str(input);
-
-    // replace escapes with double escape sequence
-    size_t start_pos = 0;
-    while ((start_pos = str.find('\\', start_pos)) != std::string::npos) {
-        str.replace(start_pos, 1, "\\\\");
-        start_pos += 2;
-    }
-    // replace semicolons with escape sequence
-    start_pos = 0;
-    while ((start_pos = str.find(';', start_pos)) != std::string::npos) {
-        str.replace(start_pos, 1, "\\;");
-        start_pos += 2;
-    }
-    // replace double-quotes with escape sequence
-    start_pos = 0;
-    while ((start_pos = str.find('"', start_pos)) != std::string::npos) {
-        str.replace(start_pos, 1, "\\\"");
-        start_pos += 2;
-    }
-    // replace newline with escape sequence
-    start_pos = 0;
-    while ((start_pos = str.find('\n', start_pos)) != std::string::npos) {
-        str.replace(start_pos, 1, "\\n");
-        start_pos += 2;
-    }
-    // replace tab with escape sequence
-    start_pos = 0;
-    while ((start_pos = str.find('\t', start_pos)) != std::string::npos) {
-        str.replace(start_pos, 1, "\\t");
-        start_pos += 2;
-    }
+    std::string str;
+    str.reserve(input.size() + input.size() / 8);
+    stringify(input, str);
     return str;
 }
 
@@ -365,16 +433,10 @@ inline std::string stringify(const std::string& input) {
  * Escape JSON string.
  */
 inline std::string escapeJSONstring(const std::string& JSONstr) {
-    std::ostringstream destination;
-
-    // Iterate over all characters except first and last
-    for (char c : JSONstr) {
-        if (c == '\"') {
-            destination << "\\";
-        }
-        destination << c;
-    }
-    return destination.str();
+    std::string destination;
+    destination.reserve(JSONstr.size() + JSONstr.size() / 8);
+    detail::appendReplaced<'"'>(JSONstr, destination, [](char) { return "\\\""; });
+    return destination;
 }
 
 /** Valid C++ identifier, note that this does not ensure the uniqueness of identifiers returned. */
@@ -387,44 +449,182 @@ inline std::string identifier(std::string id) {
     return id;
 }
 
-// TODO (b-scholz): tidy up unescape/escape functions
-
 inline std::string unescape(
         const std::string& inputString, const std::string& needle, const std::string& replacement) {
-    std::string result = inputString;
-    size_t pos = 0;
-    while ((pos = result.find(needle, pos)) != std::string::npos) {
-        result = result.replace(pos, needle.length(), replacement);
-        pos += replacement.length();
+    return detail::replaceAll(inputString, needle, replacement);
+}
+
+/**
+ * Append a string to a sink replacing the escape sequences of double-quotes, tab, carriage return and
+ * newline by the characters. Escapes not followed by one of these are kept.
+ */
+inline void unescape(std::string_view input, std::string& out) {
+    for (std::size_t pos = 0; pos < input.size();) {
+        std::size_t next = pos + simd::findFirstOf(input.data() + pos, input.size() - pos, '\\');
+        out.append(input.data() + pos, next - pos);
+        if (next == input.size()) {
+            break;
+        }
+        char c = next + 1 < input.size() ? input[next + 1] : '\0';
+        switch (c) {
+            case '"': out.push_back('"'); break;
+            case 't': out.push_back('\t'); break;
+            case 'r': out.push_back('\r'); break;
+            case 'n': out.push_back('\n'); break;
+            default:
+                // the character after the escape may start another escape sequence
+                out.push_back('\\');
+                pos = next + 1;
+                continue;
+        }
+        pos = next + 2;
     }
-    return result;
 }
 
 inline std::string unescape(const std::string& inputString) {
-    std::string unescaped = unescape(inputString, "\\\"", "\"");
-    unescaped = unescape(unescaped, "\\t", "\t");
-    unescaped = unescape(unescaped, "\\r", "\r");
-    unescaped = unescape(unescaped, "\\n", "\n");
+    std::string unescaped;
+    unescaped.reserve(inputString.size());
+    unescape(inputString, unescaped);
     return unescaped;
 }
 
 inline std::string escape(
         const std::string& inputString, const std::string& needle, const std::string& replacement) {
-    std::string result = inputString;
-    size_t pos = 0;
-    while ((pos = result.find(needle, pos)) != std::string::npos) {
-        result = result.replace(pos, needle.length(), replacement);
-        pos += replacement.length();
-    }
-    return result;
+    return detail::replaceAll(inputString, needle, replacement);
+}
+
+/**
+ * Append a string to a sink using escapes for double-quotes, tab, carriage return and newline
+ */
+inline void escape(std::string_view input, std::string& out) {
+    detail::appendReplaced<'"', '\t', '\r', '\n'>(input, out, [](char c) -> std::string_view {
+        switch (c) {
+            case '"': return "\\\"";
+            case '\t': return "\\t";
+            case '\r': return "\\r";
+            default: return "\\n";
+        }
+    });
 }
 
 inline std::string escape(const std::string& inputString) {
-    std::string escaped = escape(inputString, "\"", "\\\"");
-    escaped = escape(escaped, "\t", "\\t");
-    escaped = escape(escaped, "\r", "\\r");
-    escaped = escape(escaped, "\n", "\\n");
+    std::string escaped;
+    escaped.reserve(inputString.size() + inputString.size() / 8);
+    escape(inputString, escaped);
     return escaped;
 }
 
+/**
+ * Splits a buffer into fields at a delimiter without copying it: fields are views of the buffer, so it
+ * must outlive them.
+ *
+ * Delimiters are located a block of bytes at a time, see simd::findFirstOf, and escape sequences are
+ * only noted while scanning; they are replaced on demand by Field::value(), which copies just the
+ * fields holding them. A field starting with the quote character, if one is given, extends to the
+ * matching unescaped quote and may hold delimiters; the closing quote must be followed by a delimiter
+ * or the end of the input, otherwise next() throws std::invalid_argument. Unquoted fields are split
+ * like by splitString(), i.e., an empty input has no fields and a trailing delimiter does not start an
+ * empty field.
+ */
+class FieldTokenizer {
+public:
+    /** A field of the input */
+    struct Field {
+        /** The text of the field, without quotes but with the escape sequences of the input */
+        std::string_view text;
+
+        /** Whether the text holds escape sequences */
+        bool escaped = false;
+
+        /** The unescaped text of the field; only fields holding escape sequences are unescaped, into the
+         * given buffer, while the others are returned as they are */
+        std::string_view value(std::string& buffer) const {
+            if (!escaped) {
+                return text;
+            }
+            buffer.clear();
+            unescape(text, buffer);
+            return buffer;
+        }
+    };
+
+    FieldTokenizer(std::string_view input, char delimiter, char quote = '\0')
+            : input(input), delimiter(delimiter), quote(quote) {}
+
+    /** Advance to the next field, returning false at the end of the input; throws std::invalid_argument
+     * if a quoted field is followed by text other than a delimiter */
+    bool next(Field& field) {
+        if (pos >= input.size()) {
+            return false;
+        }
+        field.escaped = false;
+        std::size_t begin = pos;
+        if (quote != '\0' && input[pos] == quote) {
+            begin = ++pos;
+            // an escaped quote does not close the field
+            while ((pos = find(pos, quote, '\\')) < input.size() && input[pos] == '\\') {
+                field.escaped = true;
+                pos += 2;
+            }
+            field.text = input.substr(begin, pos - begin);
+            // the closing quote, if any, ends the field
+            if (pos < input.size() && ++pos < input.size() && input[pos] != delimiter) {
+                throw std::invalid_argument("text after the closing quote of a field");
+            }
+            ++pos;
+            return true;
+        }
+        while ((pos = find(pos, delimiter, '\\')) < input.size() && input[pos] == '\\') {
+            field.escaped = true;
+            ++pos;
+        }
+        field.text = input.substr(begin, pos - begin);
+        ++pos;
+        return true;
+    }
+
+private:
+    std::string_view input;
+    char delimiter;
+    char quote;
+
+    /** Position of the next field */
+    std::size_t pos = 0;
+
+    /** Convenience method to find the first of the given characters from a position on */
+    template <typename... Chars>
+    std::size_t find(std::size_t from, Chars... needles) const {
+        if (from >= input.size()) {
+            return input.size();
+        }
+        return from + simd::findFirstOf(input.data() + from, input.size() - from, needles...);
+    }
+};
+
+/**
+ * Splits a string given a delimiter
+ */
+inline std::vector<std::string> splitString(const std::string& str, char delimiter) {
+    std::vector<std::string> parts;
+    FieldTokenizer fields(str, delimiter);
+    for (FieldTokenizer::Field field; fields.next(field);) {
+        parts.emplace_back(field.text);
+    }
+    return parts;
+}
+
+/**
+ * Splits a string given a delimiter, allocating the parts from the given memory resource, e.g., a
+ * SizeClassPool; the parts are the same as those of the overload above.
+ */
+inline std::pmr::vector<std::pmr::string> splitString(
+        const std::string& str, char delimiter, std::pmr::memory_resource* resource) {
+    std::pmr::vector<std::pmr::string> parts(resource);
+    FieldTokenizer fields(str, delimiter);
+    for (FieldTokenizer::Field field; fields.next(field);) {
+        parts.emplace_back(field.text);
+    }
+    return parts;
+}
+
 }  // end namespace souffle
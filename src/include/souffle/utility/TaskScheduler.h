@@ -0,0 +1,799 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file TaskScheduler.h
+ *
+ * The task scheduler implementing task_spawn and task_sync of parallel
+ * builds: a work-stealing scheduler of the threads backend, task groups of
+ * the TBB backend, and OpenMP tasks of the OpenMP backend.
+ *
+ ***********************************************************************/
+
+#pragma once
+
+// included by ParallelUtil.h of parallel builds, providing MAX_THREADS and cpu_relax
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace souffle {
+
+namespace detail {
+
+/** Tests whether the calling thread runs within an OpenMP parallel region */
+inline bool inParallelRegion() {
+#ifdef _OPENMP
+    return omp_in_parallel();
+#else
+    return false;
+#endif
+}
+
+}  // namespace detail
+
+#if defined(SOUFFLE_PARALLEL_THREADS)
+
+namespace detail {
+
+/** Counter of the spawned, not yet completed tasks of a frame; a thread synchronizing the frame may
+ * be parked on it, see Waiter */
+struct TaskFrame {
+    std::atomic<int> pending{0};
+
+    /** Whether tasks spawned in the frame are run inline */
+    bool inlined = false;
+};
+
+/** A spawned task, completing a frame when it has been run */
+class Task {
+public:
+    Task(TaskFrame& frame, uint64_t isolation) : frame(frame), isolation(isolation) {}
+    virtual ~Task() = default;
+    virtual void run() = 0;
+
+    TaskFrame& frame;
+
+    /** The isolated region the task has been spawned in, see TaskScheduler::isolate() */
+    const uint64_t isolation;
+};
+
+template <typename F>
+class FunctionTask : public Task {
+    F body;
+
+public:
+    FunctionTask(TaskFrame& frame, uint64_t isolation, F body)
+            : Task(frame, isolation), body(std::move(body)) {}
+
+    void run() override {
+        body();
+    }
+};
+
+/**
+ * Storage of the tasks spawned by the thread owning a slot of the scheduler, recycling the blocks of
+ * completed tasks instead of going to the heap for every spawn.
+ *
+ * Only the owner allocates. A task completed by the owner returns its block to the free list of the
+ * owner; a task completed by another thread pushes its block onto a lock-free list of returns, which
+ * the owner takes over as a whole once its free list runs dry. Blocks are kept until the scheduler is
+ * destroyed; tasks exceeding a block are allocated on the heap.
+ */
+class TaskPool {
+public:
+    /** Size of the blocks, fitting a task capturing a few values or references */
+    static constexpr std::size_t blockSize = 128;
+
+private:
+    /** Number of blocks allocated at once */
+    static constexpr std::size_t batchSize = 64;
+
+    /** Preceding every task: the pool of its block, or null and the offset of a heap allocation */
+    struct alignas(std::max_align_t) Header {
+        union {
+            TaskPool* pool;
+            Header* next;
+        };
+        std::size_t offset;
+    };
+
+    struct Block {
+        Header header;
+        alignas(std::max_align_t) unsigned char payload[blockSize - sizeof(Header)];
+    };
+
+    Header* available = nullptr;
+    std::atomic<Header*> returned{nullptr};
+    std::vector<std::unique_ptr<Block[]>> batches;
+
+    /** Convenience method to allocate a task on the heap, with the header in front of it */
+    static void* allocateOnHeap(std::size_t bytes, std::size_t alignment) {
+        const std::size_t offset = std::max(alignment, sizeof(Header));
+        auto* base = static_cast<unsigned char*>(::operator new(offset + bytes, std::align_val_t(offset)));
+        auto* header = reinterpret_cast<Header*>(base + offset - sizeof(Header));
+        header->pool = nullptr;
+        header->offset = offset;
+        return base + offset;
+    }
+
+public:
+    TaskPool() = default;
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    /** Allocate the storage of a task; only called by the owner. */
+    void* allocate(std::size_t bytes, std::size_t alignment) {
+        if (bytes > sizeof(Block::payload) || alignment > alignof(Header)) {
+            return allocateOnHeap(bytes, alignment);
+        }
+        if (available == nullptr) {
+            available = returned.exchange(nullptr, std::memory_order_acquire);
+        }
+        if (available == nullptr) {
+            batches.emplace_back(new Block[batchSize]);
+            for (std::size_t i = 0; i < batchSize; ++i) {
+                batches.back()[i].header.next = available;
+                available = &batches.back()[i].header;
+            }
+        }
+        Header* header = available;
+        available = header->next;
+        header->pool = this;
+        return reinterpret_cast<Block*>(header)->payload;
+    }
+
+    /** Release the storage of a task; called by any thread, which may own a pool itself. */
+    static void release(void* task, TaskPool* own) {
+        auto* header = reinterpret_cast<Header*>(static_cast<unsigned char*>(task) - sizeof(Header));
+        TaskPool* pool = header->pool;
+        if (pool == nullptr) {
+            const std::size_t offset = header->offset;
+            ::operator delete(static_cast<unsigned char*>(task) - offset, std::align_val_t(offset));
+        } else if (pool == own) {
+            header->next = pool->available;
+            pool->available = header;
+        } else {
+            header->next = pool->returned.load(std::memory_order_relaxed);
+            while (!pool->returned.compare_exchange_weak(
+                    header->next, header, std::memory_order_release, std::memory_order_relaxed)) {
+            }
+        }
+    }
+};
+
+/**
+ * A fixed-capacity work-stealing deque of tasks after Chase and Lev.
+ *
+ * The owning thread pushes and pops tasks at the bottom; other threads steal tasks from the top.
+ * Either end may be restricted to the tasks of an isolated region; the region of a task is kept next
+ * to it, such that it can be checked without touching a task another thread may have taken.
+ */
+class TaskDeque {
+public:
+    static constexpr int64_t capacity = 1024;
+
+private:
+    alignas(64) std::atomic<int64_t> top{0};
+    alignas(64) std::atomic<int64_t> bottom{0};
+    std::array<std::atomic<Task*>, capacity> tasks{};
+    std::array<std::atomic<uint64_t>, capacity> isolations{};
+
+public:
+    /** Region matching the tasks of every isolated region */
+    static constexpr uint64_t anyIsolation = ~uint64_t(0);
+
+private:
+    static bool matches(uint64_t isolation, uint64_t wanted) {
+        return wanted == anyIsolation || isolation == wanted;
+    }
+
+public:
+    /** The approximate number of tasks; exact for the owner */
+    int64_t size() const {
+        return bottom.load(std::memory_order_relaxed) - top.load(std::memory_order_relaxed);
+    }
+
+    /** Push a task at the bottom; only called by the owner. Fails if the deque is full. */
+    bool push(Task* task) {
+        int64_t b = bottom.load(std::memory_order_relaxed);
+        int64_t t = top.load(std::memory_order_acquire);
+        if (b - t >= capacity) {
+            return false;
+        }
+        tasks[b % capacity].store(task, std::memory_order_relaxed);
+        isolations[b % capacity].store(task->isolation, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    /** Pop the task at the bottom if it belongs to the given region; only called by the owner. */
+    Task* pop(uint64_t isolation = anyIsolation) {
+        int64_t b = bottom.load(std::memory_order_relaxed) - 1;
+        // the slot below the bottom is only written by the owner
+        if (b < top.load(std::memory_order_relaxed) ||
+                !matches(isolations[b % capacity].load(std::memory_order_relaxed), isolation)) {
+            return nullptr;
+        }
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_release);
+            return nullptr;
+        }
+        Task* task = tasks[b % capacity].load(std::memory_order_relaxed);
+        if (t == b) {
+            // the last task may be stolen concurrently
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                task = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_release);
+        }
+        return task;
+    }
+
+    /** Steal the task at the top if it belongs to the given region; called by any thread. */
+    Task* steal(uint64_t isolation = anyIsolation) {
+        int64_t t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t b = bottom.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        // the slot is not reused before top moves past it, so the region read belongs to the task
+        // claimed by a successful exchange of top
+        if (!matches(isolations[t % capacity].load(std::memory_order_relaxed), isolation)) {
+            return nullptr;
+        }
+        Task* task = tasks[t % capacity].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return task;
+    }
+};
+
+}  // namespace detail
+
+/**
+ * @class TaskScheduler
+ *
+ * A work-stealing scheduler of fine-grained tasks, backing task_spawn, task_sync and sections.
+ *
+ * Every thread spawning tasks owns a deque, and a pool storing its tasks. Spawned tasks are pushed onto
+ * the deque of the spawning thread (help-first), which continues with the code following the spawn.
+ * A pool of MAX_THREADS - 1 worker threads steals tasks from the top of the deques, i.e., the oldest and
+ * typically largest tasks. A thread waiting in task_sync runs its own tasks and steals tasks of others
+ * until the tasks of its frame have completed. Waiting within an isolated region, see isolate(), only
+ * runs tasks spawned within that region, such that a thread holding a lock while waiting does not pick
+ * up unrelated tasks that may acquire the same lock.
+ *
+ * Tasks are run inline, without any scheduling overhead, if there are no workers, or if the deque of the
+ * spawning thread is full or holds enough tasks to keep all workers busy; this bounds the overhead of
+ * fine-grained recursive tasks.
+ *
+ * Each task runs in a frame of its own, which is synchronized implicitly when the task ends. A frame
+ * of code not run as a task is shared by all code of its thread outside of tasks.
+ */
+class TaskScheduler {
+    /** Maximal number of threads owning a deque at the same time */
+    static constexpr size_t maxDeques = 256;
+
+    /** Number of tasks in a deque, per worker, beyond which further tasks are run inline */
+    static constexpr int64_t inlineDepthPerWorker = 2;
+
+    /** State of a thread interacting with the scheduler */
+    struct ThreadState {
+        TaskScheduler* scheduler = nullptr;
+        size_t slot = maxDeques;
+        detail::TaskFrame root;
+        detail::TaskFrame* frame = &root;
+        uint64_t isolation = 0;
+        uint32_t seed = 0;
+
+        ~ThreadState() {
+            if (scheduler != nullptr && slot != maxDeques) {
+                scheduler->releaseSlot(slot);
+            }
+        }
+    };
+
+    /** The deques, allocated on first use and kept until the scheduler is destroyed */
+    std::array<std::atomic<detail::TaskDeque*>, maxDeques> deques{};
+
+    /** The storage of the tasks spawned from each slot, allocated along with its deque */
+    std::array<detail::TaskPool*, maxDeques> pools{};
+
+    /** Number of slots of deques used so far */
+    std::atomic<size_t> numSlots{0};
+
+    /** Slots of deques released by terminated threads */
+    std::vector<size_t> freeSlots;
+
+    /** The pool of worker threads */
+    std::vector<std::thread> workers;
+
+    /** Number of tasks in a deque beyond which further tasks are run inline */
+    const int64_t inlineDepth;
+
+    /** Synchronization of the slots and of idle workers; wakeups counts the notifications of sleeping
+     * workers, both under the mutex */
+    std::mutex mutex;
+    std::condition_variable idle;
+    std::atomic<size_t> sleepers{0};
+    uint64_t wakeups = 0;
+    bool stop = false;
+
+    /** Source of the identifiers of isolated regions; 0 is the region outside of any */
+    std::atomic<uint64_t> isolations{0};
+
+    static ThreadState& threadState() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    /** Convenience method to obtain the deque of the calling thread, assigning one if needed; returns null if
+     * all slots are in use */
+    detail::TaskDeque* ownDeque(ThreadState& state) {
+        if (state.slot == maxDeques) {
+            std::lock_guard<std::mutex> guard(mutex);
+            if (!freeSlots.empty()) {
+                state.slot = freeSlots.back();
+                freeSlots.pop_back();
+            } else if (numSlots < maxDeques) {
+                state.slot = numSlots;
+                pools[state.slot] = new detail::TaskPool();
+                deques[state.slot].store(new detail::TaskDeque(), std::memory_order_release);
+                numSlots.store(state.slot + 1, std::memory_order_release);
+            } else {
+                return nullptr;
+            }
+            state.scheduler = this;
+            state.seed = static_cast<uint32_t>(state.slot) * 2654435761u + 1;
+        }
+        return deques[state.slot].load(std::memory_order_relaxed);
+    }
+
+    /** Convenience method to obtain the task storage of the calling thread, if it owns a slot */
+    detail::TaskPool* ownPool(const ThreadState& state) const {
+        return (state.slot == maxDeques) ? nullptr : pools[state.slot];
+    }
+
+    /** Convenience method to destroy a task and to release its storage */
+    void destroy(const ThreadState& state, detail::Task* task) {
+        void* storage = dynamic_cast<void*>(task);
+        task->~Task();
+        detail::TaskPool::release(storage, ownPool(state));
+    }
+
+    void releaseSlot(size_t slot) {
+        std::lock_guard<std::mutex> guard(mutex);
+        freeSlots.push_back(slot);
+    }
+
+    /** Convenience method to test whether any deque holds a task */
+    bool hasTasks() const {
+        const size_t n = numSlots.load(std::memory_order_acquire);
+        for (size_t slot = 0; slot < n; ++slot) {
+            if (deques[slot].load(std::memory_order_acquire)->size() > 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /** Convenience method to wake up a sleeping worker, if there is one, after a task has been pushed */
+    void wakeOne() {
+        // pairs with the fence of a worker going to sleep: either the worker finds the task, or the
+        // spawning thread finds the worker
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            ++wakeups;
+        }
+        idle.notify_one();
+    }
+
+    /** Convenience method to steal a task of the given region of any other thread, starting at a random
+     * deque */
+    detail::Task* steal(ThreadState& state, uint64_t isolation) {
+        const size_t n = numSlots.load(std::memory_order_acquire);
+        state.seed = state.seed * 1664525u + 1013904223u;
+        const size_t start = (state.seed >> 8) % (n == 0 ? 1 : n);
+        for (size_t i = 0; i < n; ++i) {
+            size_t slot = (start + i) % n;
+            if (slot == state.slot) {
+                continue;
+            }
+            if (detail::Task* task = deques[slot].load(std::memory_order_acquire)->steal(isolation)) {
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    /** Convenience method to run a body in a frame of its own, synchronizing the frame in the end */
+    template <typename F>
+    void runInFrame(ThreadState& state, F&& body) {
+        detail::TaskFrame frame;
+        detail::TaskFrame* outer = state.frame;
+        state.frame = &frame;
+        body();
+        sync();
+        state.frame = outer;
+    }
+
+    /** Convenience method to run a task within its region and complete it in its frame */
+    void execute(ThreadState& state, detail::Task* task) {
+        const uint64_t outer = state.isolation;
+        state.isolation = task->isolation;
+        runInFrame(state, [&]() { task->run(); });
+        state.isolation = outer;
+        detail::TaskFrame& frame = task->frame;
+        destroy(state, task);
+        // the frame may be gone once the counter drops to zero; waking the threads parked on its address
+        // does not touch it
+        if (frame.pending.fetch_sub(1, std::memory_order_seq_cst) == 1) {
+            detail::unpark(frame.pending);
+        }
+    }
+
+    /** Convenience method to run a task of the given region of the calling thread or of any other thread, if
+     * there is one */
+    bool runOne(ThreadState& state, uint64_t isolation) {
+        detail::TaskDeque* deque = ownDeque(state);
+        detail::Task* task = (deque != nullptr) ? deque->pop(isolation) : nullptr;
+        if (task == nullptr) {
+            task = steal(state, isolation);
+        }
+        if (task == nullptr) {
+            return false;
+        }
+        execute(state, task);
+        return true;
+    }
+
+    void workerLoop() {
+        ThreadState& state = threadState();
+        size_t misses = 0;
+        while (true) {
+            if (runOne(state, detail::TaskDeque::anyIsolation)) {
+                misses = 0;
+            } else if (++misses < 1000) {
+                cpu_relax();
+            } else {
+                // nothing to do for a while => sleep until woken up by a spawn or by the shutdown
+                std::unique_lock<std::mutex> lock(mutex);
+                sleepers.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (!stop && !hasTasks()) {
+                    const uint64_t seen = wakeups;
+                    idle.wait(lock, [&]() { return stop || wakeups != seen; });
+                }
+                sleepers.fetch_sub(1, std::memory_order_relaxed);
+                if (stop) {
+                    return;
+                }
+                misses = 0;
+            }
+        }
+    }
+
+    explicit TaskScheduler(size_t numWorkers)
+            : inlineDepth(std::min<int64_t>(detail::TaskDeque::capacity,
+                      inlineDepthPerWorker * static_cast<int64_t>(numWorkers))) {
+        for (size_t i = 0; i < numWorkers; ++i) {
+            workers.emplace_back([this]() { workerLoop(); });
+        }
+    }
+
+public:
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    ~TaskScheduler() {
+        {
+            std::lock_guard<std::mutex> guard(mutex);
+            stop = true;
+        }
+        idle.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        for (auto& deque : deques) {
+            delete deque.load();
+        }
+        for (detail::TaskPool* pool : pools) {
+            delete pool;
+        }
+    }
+
+    /** The scheduler of the process, starting its workers on first use */
+    static TaskScheduler& instance() {
+        static TaskScheduler scheduler(MAX_THREADS > 1 ? MAX_THREADS - 1 : 0);
+        return scheduler;
+    }
+
+    /** The number of worker threads */
+    size_t numWorkers() const {
+        return workers.size();
+    }
+
+    /** Spawn a task running the given function in the current frame of the calling thread. */
+    template <typename F>
+    void spawn(F&& body) {
+        if (workers.empty()) {
+            body();
+            return;
+        }
+        ThreadState& state = threadState();
+        detail::TaskDeque* deque = state.frame->inlined ? nullptr : ownDeque(state);
+        if (deque == nullptr || deque->size() >= inlineDepth) {
+            runInFrame(state, body);
+            return;
+        }
+        using FunctionTask = detail::FunctionTask<std::decay_t<F>>;
+        void* storage = ownPool(state)->allocate(sizeof(FunctionTask), alignof(FunctionTask));
+        auto* task = new (storage) FunctionTask(*state.frame, state.isolation, std::forward<F>(body));
+        state.frame->pending.fetch_add(1, std::memory_order_relaxed);
+        if (!deque->push(task)) {
+            state.frame->pending.fetch_sub(1, std::memory_order_relaxed);
+            runInFrame(state, [&]() { task->run(); });
+            destroy(state, task);
+            return;
+        }
+        wakeOne();
+    }
+
+    /**
+     * A frame of tasks for the life-cycle of a scope, synchronized when the scope ends.
+     *
+     * Independent blocks of code spawned within the scope, e.g., sections, run on the workers. Unless
+     * disabled, if the scope is nested within a task, within another scope, or within an OpenMP parallel
+     * region, the threads are assumed to be busy and the blocks are run inline.
+     */
+    class Scope {
+        ThreadState& state;
+        detail::TaskFrame frame;
+        detail::TaskFrame* outer;
+
+    public:
+        explicit Scope(bool inlineNested = true) : state(threadState()), outer(state.frame) {
+            frame.inlined = inlineNested && (outer != &state.root || detail::inParallelRegion());
+            state.frame = &frame;
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() {
+            instance().sync();
+            state.frame = outer;
+        }
+    };
+
+    /** Wait until all tasks spawned in the current frame of the calling thread have completed, running
+     * pending tasks of the current region in the meantime. Once there are none left to run, the thread
+     * spins for a while and is then parked until the last task of the frame completes. */
+    void sync() {
+        if (workers.empty()) {
+            return;
+        }
+        ThreadState& state = threadState();
+        detail::TaskFrame& frame = *state.frame;
+        detail::Waiter wait;
+        int pending;
+        while ((pending = frame.pending.load(std::memory_order_acquire)) != 0) {
+            if (!runOne(state, state.isolation)) {
+                wait(frame.pending, pending);
+            }
+        }
+    }
+
+    /** Run a body in an isolated region: while waiting for tasks, the calling thread only runs tasks
+     * spawned within the body, like tbb::this_task_arena::isolate. */
+    template <typename F>
+    void isolate(const F& body) {
+        ThreadState& state = threadState();
+        const uint64_t outer = state.isolation;
+        state.isolation = isolations.fetch_add(1, std::memory_order_relaxed) + 1;
+        body();
+        state.isolation = outer;
+    }
+};
+
+#elif defined(SOUFFLE_PARALLEL_TBB)
+
+/**
+ * @class TaskScheduler
+ *
+ * The task scheduler of the TBB backend, running tasks in task groups of the parallel arena.
+ *
+ * Like the work-stealing scheduler of the other backends, each task runs in a frame of its own, which
+ * is synchronized implicitly when the task ends; a frame owns the task group of the tasks spawned in it.
+ */
+class TaskScheduler {
+    struct Frame {
+        tbb::task_group group;
+        bool spawned = false;
+        bool inlined = false;
+    };
+
+    struct ThreadState {
+        Frame root;
+        Frame* frame = &root;
+    };
+
+    static ThreadState& threadState() {
+        static thread_local ThreadState state;
+        return state;
+    }
+
+    /** Convenience method to run a body in a frame of its own, synchronizing the frame in the end */
+    template <typename F>
+    void runInFrame(F& body) {
+        ThreadState& state = threadState();
+        Frame frame;
+        Frame* outer = state.frame;
+        state.frame = &frame;
+        body();
+        sync();
+        state.frame = outer;
+    }
+
+    TaskScheduler() = default;
+
+public:
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /** The scheduler of the process */
+    static TaskScheduler& instance() {
+        static TaskScheduler scheduler;
+        return scheduler;
+    }
+
+    /** The number of threads of the arena besides the calling one */
+    size_t numWorkers() const {
+        return MAX_THREADS > 1 ? MAX_THREADS - 1 : 0;
+    }
+
+    /** Spawn a task running the given function in the current frame of the calling thread. */
+    template <typename F>
+    void spawn(F&& body) {
+        Frame& frame = *threadState().frame;
+        if (frame.inlined) {
+            runInFrame(body);
+            return;
+        }
+        frame.spawned = true;
+        detail::parallelArena().execute([&]() {
+            frame.group.run([this, task = std::decay_t<F>(std::forward<F>(body))]() { runInFrame(task); });
+        });
+    }
+
+    /** A frame of tasks for the life-cycle of a scope, synchronized when the scope ends; see above. */
+    class Scope {
+        ThreadState& state;
+        Frame frame;
+        Frame* outer;
+
+    public:
+        explicit Scope(bool inlineNested = true) : state(threadState()), outer(state.frame) {
+            frame.inlined = inlineNested && (outer != &state.root || detail::inParallelRegion());
+            state.frame = &frame;
+        }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() {
+            instance().sync();
+            state.frame = outer;
+        }
+    };
+
+    /** Wait until all tasks spawned in the current frame of the calling thread have completed. */
+    void sync() {
+        Frame& frame = *threadState().frame;
+        if (frame.spawned) {
+            detail::parallelArena().execute([&]() { frame.group.wait(); });
+            frame.spawned = false;
+        }
+    }
+
+    /** Run a body in an isolated region: while waiting for tasks, the calling thread only runs tasks
+     * spawned within the body. */
+    template <typename F>
+    void isolate(const F& body) {
+        tbb::this_task_arena::isolate(body);
+    }
+};
+
+#else
+
+/**
+ * @class TaskScheduler
+ *
+ * The task scheduler of the OpenMP backend, running tasks as OpenMP tasks, such that tasks and parallel
+ * loops share the threads of the OpenMP runtime.
+ *
+ * Tasks are deferred to the other threads of a team only within a parallel region; outside of one, the
+ * team of the calling thread is the thread itself, which runs them. Like on the other backends, each task
+ * runs in a frame of its own, which is synchronized implicitly when the task ends. Tasks are tied, so a
+ * thread waiting for the tasks of its frame only runs tasks descending from the task it waits in.
+ */
+class TaskScheduler {
+    TaskScheduler() = default;
+
+public:
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+    /** The scheduler of the process */
+    static TaskScheduler& instance() {
+        static TaskScheduler scheduler;
+        return scheduler;
+    }
+
+    /** The number of threads of a team besides the calling one */
+    size_t numWorkers() const {
+        return MAX_THREADS > 1 ? MAX_THREADS - 1 : 0;
+    }
+
+    /** Spawn a task running the given function in the current frame of the calling thread. */
+    template <typename F>
+    void spawn(F&& body) {
+        auto task = std::decay_t<F>(std::forward<F>(body));
+#pragma omp task firstprivate(task)
+        {
+            task();
+#pragma omp taskwait
+        }
+    }
+
+    /** A frame of tasks for the life-cycle of a scope, synchronized when the scope ends; the scope waits
+     * for all tasks spawned by the current task, which include those spawned within the scope. */
+    class Scope {
+    public:
+        explicit Scope(bool = true) {}
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        ~Scope() {
+            instance().sync();
+        }
+    };
+
+    /** Wait until all tasks spawned in the current frame of the calling thread have completed. */
+    void sync() {
+#pragma omp taskwait
+    }
+
+    /** Run a body in an isolated region; waiting tied tasks only run their descendants anyway. */
+    template <typename F>
+    void isolate(const F& body) {
+        body();
+    }
+};
+
+#endif
+
+}  // end of namespace souffle
@@ -0,0 +1,96 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file arena_allocator_parallel_test.cpp
+ *
+ * Tests the arena and the pool of size classes in parallel.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/utility/ArenaAllocator.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+TEST(Allocators, Concurrent) {
+    // threads allocating from one arena receive disjoint memory
+    Arena arena;
+    std::vector<std::vector<size_t*>> blocks(4);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = 0; i < 20000; ++i) {
+                auto* block = static_cast<size_t*>(arena.allocate(sizeof(size_t) * (1 + i % 5)));
+                std::fill(block, block + 1 + i % 5, t * 20000 + i);
+                blocks[t].push_back(block);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    size_t overwritten = 0;
+    for (size_t t = 0; t < 4; ++t) {
+        for (size_t i = 0; i < blocks[t].size(); ++i) {
+            overwritten += std::count(blocks[t][i], blocks[t][i] + 1 + i % 5, t * 20000 + i) !=
+                          static_cast<std::ptrdiff_t>(1 + i % 5);
+        }
+    }
+    EXPECT_EQ(0, overwritten);
+
+    // blocks of a pool released by other threads than their allocating ones are reused
+    SizeClassPool pool;
+    std::vector<void*> handedOver(4 * 1000);
+    workers.clear();
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = 0; i < 1000; ++i) {
+                handedOver[t * 1000 + i] = pool.allocate(64);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    workers.clear();
+    std::atomic<size_t> corrupted{0};
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            // release the blocks of the next thread, then churn
+            for (size_t i = 0; i < 1000; ++i) {
+                pool.deallocate(handedOver[((t + 1) % 4) * 1000 + i], 64);
+            }
+            for (size_t round = 0; round < 100; ++round) {
+                std::vector<size_t*> mine;
+                for (size_t i = 0; i < 50; ++i) {
+                    mine.push_back(static_cast<size_t*>(pool.allocate(64)));
+                    *mine.back() = t;
+                }
+                for (size_t* block : mine) {
+                    corrupted += (*block != t);
+                    pool.deallocate(block, 64);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(0, corrupted);
+}
+
+}  // namespace souffle::test
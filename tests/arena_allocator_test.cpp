@@ -0,0 +1,83 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file arena_allocator_test.cpp
+ *
+ * Tests the arena and the pool of size classes.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/utility/ArenaAllocator.h"
+#include "souffle/utility/PageAllocator.h"
+#include "souffle/utility/StringUtil.h"
+#include <algorithm>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace souffle::test {
+
+TEST(Allocators, ArenaAndPool) {
+    // arenas and pools hand out aligned, disjoint memory, and pools reuse released blocks
+    Arena arena;
+    std::vector<std::pair<char*, size_t>> blocks;
+    size_t misaligned = 0;
+    for (size_t i = 0; i < 10000; ++i) {
+        size_t size = 1 + (i * 37) % 300;
+        size_t alignment = size_t(1) << (i % 7);
+        auto* block = static_cast<char*>(arena.allocate(size, alignment));
+        misaligned += (reinterpret_cast<uintptr_t>(block) % alignment != 0);
+        std::fill(block, block + size, static_cast<char>(i));
+        blocks.emplace_back(block, size);
+    }
+    size_t overwritten = 0;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        char* first = blocks[i].first;
+        overwritten += std::count(first, first + blocks[i].second, static_cast<char>(i)) !=
+                       static_cast<std::ptrdiff_t>(blocks[i].second);
+    }
+    EXPECT_EQ(0, misaligned);
+    EXPECT_EQ(0, overwritten);
+
+    SizeClassPool pool;
+    void* small = pool.allocate(40);
+    pool.deallocate(small, 40);
+    EXPECT_EQ(small, pool.allocate(48));
+    void* large = pool.allocate(SizeClassPool::maxBlockSize + 1);
+    pool.deallocate(large, SizeClassPool::maxBlockSize + 1);
+
+    // the parts split into a pool equal the plain ones
+    for (std::string str : {"", "a", "a,b", ",a,,b,", "a long part, beyond the small string buffer"}) {
+        auto parts = splitString(str, ',', &pool);
+        auto expected = splitString(str, ',');
+        EXPECT_EQ(expected.size(), parts.size());
+        EXPECT_TRUE(std::equal(expected.begin(), expected.end(), parts.begin(), parts.end(),
+                [](const std::string& a, const std::pmr::string& b) {
+                    return std::string_view(a) == std::string_view(b);
+                }));
+    }
+
+    // records allocated from a pool
+    RecordTable recordTable(PagePolicy(), &pool);
+    RamDomain tuple[3] = {1, 2, 3};
+    RamDomain ref = recordTable.pack(tuple, 3);
+    EXPECT_TRUE(std::equal(tuple, tuple + 3, recordTable.unpack(ref, 3)));
+}
+
+}  // namespace souffle::test
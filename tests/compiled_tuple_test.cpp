@@ -0,0 +1,62 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file compiled_tuple_test.cpp
+ *
+ * Tests the tuples of compiled programs.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include <algorithm>
+#include <random>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+#define NUMBER_OF_TESTS 100
+
+// Count the tuple comparisons disagreeing with the lexicographic order of the components
+template <size_t Arity>
+size_t countComparisonErrors() {
+    size_t errors = 0;
+    std::default_random_engine randomGenerator(Arity);
+    std::uniform_int_distribution<RamDomain> distribution(-2, 2);
+    for (size_t n = 0; n < NUMBER_OF_TESTS; ++n) {
+        Tuple<RamDomain, Arity> a;
+        Tuple<RamDomain, Arity> b;
+        for (size_t i = 0; i < Arity; ++i) {
+            a[i] = distribution(randomGenerator);
+            b[i] = (i + 1 < Arity) ? a[i] : distribution(randomGenerator);
+        }
+        if (n % 2 == 0) {
+            b[n % Arity] = distribution(randomGenerator);
+        }
+        bool less = std::lexicographical_compare(a.data, a.data + Arity, b.data, b.data + Arity);
+        bool greater = std::lexicographical_compare(b.data, b.data + Arity, a.data, a.data + Arity);
+        errors += (less != (a < b)) + (greater != (a > b)) + ((!less && !greater) != (a == b));
+    }
+    return errors;
+}
+
+TEST(Tuple, Comparison) {
+    EXPECT_EQ(0, countComparisonErrors<1>());
+    EXPECT_EQ(0, countComparisonErrors<3>());
+    EXPECT_EQ(0, countComparisonErrors<4>());
+    EXPECT_EQ(0, countComparisonErrors<7>());
+    EXPECT_EQ(0, countComparisonErrors<12>());
+    EXPECT_EQ(0, countComparisonErrors<33>());
+}
+
+}  // namespace souffle::test
@@ -0,0 +1,72 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file hash_util_test.cpp
+ *
+ * Tests the hash functions.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/HashUtil.h"
+#include "souffle/utility/SimdUtil.h"
+#include <functional>
+#include <numeric>
+#include <string>
+#include <vector>
+
+namespace souffle::test {
+
+TEST(Hash, TupleMatchesRecord) {
+    // tuples hash like records of the same content
+    const Tuple<RamDomain, 5> tuple = {{1, -2, 3, 4, 5}};
+    const std::vector<RamDomain> record = {1, -2, 3, 4, 5};
+    const std::hash<Tuple<RamDomain, 5>> tupleHash;
+    EXPECT_EQ(tupleHash(tuple), hashDomains(record.data(), record.size()));
+
+    Tuple<RamDomain, 5> other = tuple;
+    EXPECT_EQ(tupleHash(tuple), tupleHash(other));
+}
+
+TEST(Hash, BlockOrder) {
+    // swapping two blocks of the input changes the hash of each kernel
+    const std::string a(32, 'a');
+    const std::string b = "/src/include/souffle/utility/x.h";
+    const std::string tail = "tail";
+    std::vector<detail::HashKernel> kernels = {&detail::hashBytesPortable};
+#ifdef SOUFFLE_SIMD_X86
+    if (simd::hasSSE42()) {
+        kernels.push_back(&detail::hashBytesSSE42);
+    }
+    if (simd::hasAVX2() && simd::hasSSE42()) {
+        kernels.push_back(&detail::hashBytesAVX2);
+    }
+#endif
+    for (const std::string& prefix : {std::string(), std::string(32, 'p')}) {
+        const std::string ab = prefix + a + b + tail;
+        const std::string ba = prefix + b + a + tail;
+        for (detail::HashKernel kernel : kernels) {
+            EXPECT_TRUE(kernel(ab.data(), ab.size()) != kernel(ba.data(), ba.size()));
+        }
+        EXPECT_TRUE(hashString(ab) != hashString(ba));
+    }
+
+    // records of equal blocks in another order
+    std::vector<RamDomain> record(32);
+    std::iota(record.begin(), record.end(), 0);
+    std::vector<RamDomain> permuted(record.begin() + 16, record.end());
+    permuted.insert(permuted.end(), record.begin(), record.begin() + 16);
+    EXPECT_TRUE(hashDomains(record.data(), 32) != hashDomains(permuted.data(), 32));
+}
+
+}  // namespace souffle::test
@@ -0,0 +1,72 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file page_allocator_test.cpp
+ *
+ * Tests the page policies of large allocations.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/RecordTable.h"
+#include "souffle/utility/PageAllocator.h"
+#include <vector>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+TEST(PagePolicy, Tables) {
+    // page policies round-trip through their textual form, and tables of every policy work alike
+    EXPECT_EQ("normal,first-touch", PagePolicy().toString());
+    EXPECT_EQ("transparent,first-touch", PagePolicy::parse("transparent").toString());
+    EXPECT_EQ("explicit,interleave", PagePolicy::parse("explicit,interleave").toString());
+    EXPECT_EQ("normal,local", PagePolicy::parse("local,bogus").toString());
+
+    for (const char* name : {"normal", "transparent,local", "explicit,interleave"}) {
+        // enough records for index storage of several huge pages
+        RecordTable recordTable(PagePolicy::parse(name));
+        std::vector<RamDomain> references;
+        for (RamDomain i = 0; i < 300000; ++i) {
+            RamDomain tuple[2] = {i, -i};
+            references.push_back(recordTable.pack(tuple, 2));
+        }
+        size_t mismatches = 0;
+        for (RamDomain i = 0; i < 300000; ++i) {
+            RamDomain tuple[2] = {i, -i};
+            const RamDomain* record = recordTable.unpack(references[i], 2);
+            mismatches += (record[0] != i || record[1] != -i || recordTable.pack(tuple, 2) != references[i]);
+        }
+        EXPECT_EQ(0, mismatches);
+    }
+
+#ifdef __linux__
+    // refused parts of a policy are reported as their fallbacks
+    detail::PageFallbacks& fallbacks = detail::pageFallbacks();
+    const bool refused[3] = {fallbacks.explicitPages, fallbacks.transparentPages, fallbacks.placement};
+    fallbacks.explicitPages = false;
+    fallbacks.transparentPages = false;
+    fallbacks.placement = false;
+    EXPECT_EQ("explicit,interleave", appliedPagePolicy(PagePolicy::parse("explicit,interleave")).toString());
+    fallbacks.explicitPages = true;
+    fallbacks.placement = true;
+    EXPECT_EQ("transparent,first-touch", appliedPagePolicy(PagePolicy::parse("explicit,local")).toString());
+    fallbacks.transparentPages = true;
+    EXPECT_EQ("normal,first-touch", appliedPagePolicy(PagePolicy::parse("explicit,interleave")).toString());
+    fallbacks.explicitPages = refused[0];
+    fallbacks.transparentPages = refused[1];
+    fallbacks.placement = refused[2];
+#endif
+    EXPECT_EQ("normal,first-touch", appliedPagePolicy(PagePolicy()).toString());
+}
+
+}  // namespace souffle::test
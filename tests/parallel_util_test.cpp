@@ -0,0 +1,405 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file parallel_util_test.cpp
+ *
+ * Tests tasks, sections, parallel loops and locks.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace souffle::test {
+
+#define NUMBER_OF_TESTS 1000
+
+// Sort by a merge sort spawning the sorting of halves
+void mergeSort(RamDomain* first, RamDomain* last) {
+    if (last - first < 64) {
+        std::sort(first, last);
+        return;
+    }
+    RamDomain* middle = first + (last - first) / 2;
+    task_spawn(mergeSort(first, middle));
+    mergeSort(middle, last);
+    task_sync;
+    std::inplace_merge(first, middle, last);
+}
+
+TEST(Tasks, MergeSort) {
+    auto values = testutil::generateRandomVector<RamDomain>(NUMBER_OF_TESTS * 100);
+    auto expected = values;
+    std::sort(expected.begin(), expected.end());
+    mergeSort(values.data(), values.data() + values.size());
+    EXPECT_TRUE(values == expected);
+}
+
+TEST(Tasks, LargeCaptures) {
+    // tasks exceeding the blocks of the task storage, in size or in alignment, are run as well
+    struct alignas(64) Aligned {
+        RamDomain value;
+    };
+    std::array<RamDomain, 100> values;
+    std::iota(values.begin(), values.end(), 0);
+    std::vector<RamDomain> sums(64);
+    std::vector<char> aligned(64, 0);
+    TaskScheduler& scheduler = TaskScheduler::instance();
+    for (size_t i = 0; i < sums.size(); ++i) {
+        RamDomain* sum = &sums[i];
+        if (i % 2 == 0) {
+            scheduler.spawn([values, sum, i]() {
+                *sum = std::accumulate(values.begin(), values.end(), RamDomain(i));
+            });
+        } else {
+            char* isAligned = &aligned[i];
+            scheduler.spawn([offset = Aligned{RamDomain(i)}, &values, sum, isAligned]() {
+                *isAligned = reinterpret_cast<std::uintptr_t>(&offset) % alignof(Aligned) == 0;
+                *sum = std::accumulate(values.begin(), values.end(), offset.value);
+            });
+        }
+    }
+    scheduler.sync();
+    for (size_t i = 0; i < sums.size(); ++i) {
+        EXPECT_EQ(RamDomain(i) + 4950, sums[i]);
+        EXPECT_TRUE(i % 2 == 0 || aligned[i] != 0);
+    }
+}
+
+TEST(Sections, Pooled) {
+    // sections run concurrently on the workers, unless nested
+    const bool pooled = TaskScheduler::instance().numWorkers() > 0;
+
+    // with workers, each section waits for the other one to have started
+    std::atomic<int> started{0};
+    std::atomic<bool> overlapped{true};
+    auto rendezvous = [&]() {
+        started++;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (started < 2) {
+            if (std::chrono::steady_clock::now() > deadline) {
+                overlapped = false;
+                return;
+            }
+            std::this_thread::yield();
+        }
+    };
+    std::vector<RamDomain> results(2);
+    SECTIONS_START;
+    SECTION_START;
+    if (pooled) rendezvous();
+    results[0] = 1;
+    SECTION_END
+    SECTION_START;
+    if (pooled) rendezvous();
+    results[1] = 2;
+    SECTION_END
+    SECTIONS_END;
+    EXPECT_TRUE(overlapped);
+    EXPECT_EQ(1, results[0]);
+    EXPECT_EQ(2, results[1]);
+
+    // sections within a parallel region are run by the thread of the region
+    std::vector<size_t> mismatches(4);
+#pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < mismatches.size(); ++i) {
+        auto self = std::this_thread::get_id();
+        SECTIONS_START;
+        SECTION_START;
+        mismatches[i] += (std::this_thread::get_id() != self);
+        SECTION_END
+        SECTION_START;
+        mismatches[i] += (std::this_thread::get_id() != self);
+        SECTION_END
+        SECTIONS_END;
+    }
+    for (size_t mismatch : mismatches) {
+        EXPECT_EQ(0, mismatch);
+    }
+}
+
+TEST(ParallelFor, Schedules) {
+    // every iteration of a parallel loop is run exactly once, whatever the schedule
+    for (const char* name : {"static", "dynamic", "dynamic,7", "guided", "guided,100", "auto"}) {
+        LoopSchedule schedule = LoopSchedule::parse(name);
+        EXPECT_EQ(std::string(name), schedule.toString());
+
+        for (size_t n : {size_t(0), size_t(1), size_t(1000), size_t(100000)}) {
+            std::vector<std::atomic<int>> visits(n + 10);
+            parallelFor(10, n + 10, [&](size_t i) { visits[i]++; }, schedule);
+            size_t wrong = 0;
+            for (size_t i = 0; i < n + 10; ++i) {
+                wrong += visits[i] != (i < 10 ? 0 : 1);
+            }
+            EXPECT_EQ(0, wrong);
+        }
+    }
+    EXPECT_EQ(std::string("dynamic"), LoopSchedule::parse("fastest").toString());
+}
+
+TEST(ParallelFor, Isolated) {
+    // a thread waiting for the chunks of a nested loop does not pick up iterations of the outer loop
+    static thread_local bool nested = false;
+    std::atomic<size_t> reentered{0};
+    std::atomic<size_t> inner{0};
+    parallelFor(
+            0, 64,
+            [&](size_t) {
+                reentered += nested;
+                nested = true;
+                parallelFor(
+                        0, 64,
+                        [&](size_t) {
+                            auto until = std::chrono::steady_clock::now() + std::chrono::microseconds(20);
+                            while (std::chrono::steady_clock::now() < until) {
+                            }
+                            inner++;
+                        },
+                        1);
+                nested = false;
+            },
+            1);
+    EXPECT_EQ(0, reentered);
+    EXPECT_EQ(64 * 64, inner);
+}
+
+/** Increment a counter from several threads under the given lock; returns the final count */
+template <typename L>
+size_t countUnderLock(size_t threads, size_t increments) {
+    L lock;
+    size_t counter = 0;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = 0; i < increments; ++i) {
+                if ((i + t) % 4 == 0) {
+                    auto lease = lock.acquire();
+                    ++counter;
+                } else if (i % 8 == 1 && lock.try_lock()) {
+                    ++counter;
+                    lock.unlock();
+                } else {
+                    lock.lock();
+                    ++counter;
+                    lock.unlock();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return counter;
+}
+
+TEST(Locks, MutualExclusion) {
+    EXPECT_EQ(4 * 20000, countUnderLock<MCSLock>(4, 20000));
+    EXPECT_EQ(4 * 20000, countUnderLock<TicketLock>(4, 20000));
+
+    // try_lock fails while the lock is held, and succeeds once it is released
+    MCSLock mcs;
+    mcs.lock();
+    bool acquired = true;
+    std::thread([&]() { acquired = mcs.try_lock(); }).join();
+    EXPECT_FALSE(acquired);
+    mcs.unlock();
+    EXPECT_TRUE(mcs.try_lock());
+    mcs.unlock();
+
+    TicketLock ticket;
+    ticket.lock();
+    std::thread([&]() { acquired = ticket.try_lock(); }).join();
+    EXPECT_FALSE(acquired);
+    ticket.unlock();
+    EXPECT_TRUE(ticket.try_lock());
+    ticket.unlock();
+}
+
+TEST(Locks, ParkedWaiters) {
+    // readers and writers blocked by a long write are parked, and woken when it ends
+    ReadWriteLock rw;
+    OptimisticReadWriteLock optimistic;
+    size_t value = 0;
+    size_t expected = 0;
+    WaitStatistics before = getWaitStatistics();
+    rw.start_write();
+    optimistic.start_write();
+    std::vector<std::thread> workers;
+    std::vector<size_t> observed(6);
+    for (size_t t = 0; t < observed.size(); ++t) {
+        workers.emplace_back([&, t]() {
+            if (t % 3 == 0) {
+                rw.start_write();
+                ++value;
+                rw.end_write();
+            } else if (t % 3 == 1) {
+                rw.start_read();
+                observed[t] = value;
+                rw.end_read();
+            } else {
+                optimistic.start_write();
+                optimistic.end_write();
+                observed[t] = 1;
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    value = expected = 10;
+    optimistic.end_write();
+    rw.end_write();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(expected + 2, value);
+    // readers only see the values of completed writes
+    EXPECT_TRUE(observed[1] >= expected);
+    EXPECT_TRUE(observed[4] >= expected);
+    EXPECT_EQ(1, observed[2]);
+    EXPECT_EQ(1, observed[5]);
+    WaitStatistics after = getWaitStatistics();
+    EXPECT_LT(before.parks, after.parks);
+    EXPECT_LT(before.wakeups, after.wakeups);
+}
+
+TEST(Locks, BiasedReadWrite) {
+    // writers keep the two values equal, readers check them
+    BiasedReadWriteLock lock;
+    size_t a = 0;
+    size_t b = 0;
+    std::atomic<size_t> inconsistent{0};
+    std::atomic<size_t> upgrades{0};
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = 0; i < 20000; ++i) {
+                if (t == 0 && i % 100 == 0) {
+                    lock.start_write();
+                    ++a;
+                    ++b;
+                    lock.end_write();
+                } else if (i % 500 == 1) {
+                    lock.start_read();
+                    if (lock.try_upgrade_to_write()) {
+                        ++a;
+                        ++b;
+                        upgrades++;
+                        lock.downgrade_to_read();
+                    }
+                    inconsistent += (a != b);
+                    lock.end_read();
+                } else {
+                    lock.start_read();
+                    inconsistent += (a != b);
+                    lock.end_read();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(0, inconsistent);
+    EXPECT_EQ(200 + upgrades, a);
+    EXPECT_EQ(a, b);
+
+    // a writer excludes readers of other threads, and is excluded by them
+    lock.start_read();
+    bool acquired = true;
+    std::thread([&]() { acquired = lock.try_write(); }).join();
+    EXPECT_FALSE(acquired);
+    lock.end_read();
+    lock.start_write();
+    std::thread([&]() {
+        acquired = lock.try_write();
+        if (acquired) lock.end_write();
+    }).join();
+    EXPECT_FALSE(acquired);
+    lock.end_write();
+    EXPECT_TRUE(lock.try_write());
+    lock.end_write();
+}
+
+TEST(Locks, PhaseFair) {
+    // writers make progress while readers keep the lock busy
+    PhaseFairReadWriteLock lock;
+    size_t a = 0;
+    size_t b = 0;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> inconsistent{0};
+    std::atomic<size_t> upgrades{0};
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < 3; ++t) {
+        readers.emplace_back([&]() {
+            for (size_t i = 0; !done; ++i) {
+                lock.start_read();
+                if (i % 64 == 0 && lock.try_upgrade_to_write()) {
+                    ++a;
+                    ++b;
+                    upgrades++;
+                    lock.downgrade_to_read();
+                }
+                inconsistent += (a != b);
+                lock.end_read();
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (size_t t = 0; t < 2; ++t) {
+        writers.emplace_back([&]() {
+            for (size_t i = 0; i < 500; ++i) {
+                lock.start_write();
+                ++a;
+                ++b;
+                lock.end_write();
+            }
+        });
+    }
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+    EXPECT_EQ(0, inconsistent);
+    EXPECT_EQ(1000 + upgrades, a);
+    EXPECT_EQ(a, b);
+
+    // a writer excludes readers of other threads, and is excluded by them
+    lock.start_read();
+    bool acquired = true;
+    std::thread([&]() { acquired = lock.try_write(); }).join();
+    EXPECT_FALSE(acquired);
+    lock.end_read();
+    lock.start_write();
+    std::thread([&]() {
+        acquired = lock.try_write();
+        if (acquired) lock.end_write();
+    }).join();
+    EXPECT_FALSE(acquired);
+    lock.end_write();
+    EXPECT_TRUE(lock.try_write());
+    lock.end_write();
+}
+
+}  // namespace souffle::test
@@ -8,9 +8,9 @@
 
 /************************************************************************
  *
- * @file record_table_test.cpp
+ * @file record_table_parallel_test.cpp
  *
- * Tests the record table.
+ * Tests the record table in parallel.
  *
  ***********************************************************************/
 
@@ -19,11 +19,14 @@
 #include "souffle/CompiledTuple.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <limits>
 #include <random>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include <cstddef>
@@ -59,4 +62,87 @@ TEST(PackUnpack, Parallel) {
     }
 }
 
+TEST(PackUnpack, ConcurrentPack) {
+    constexpr size_t arity = 3;
+    constexpr size_t numRecords = 5000;
+    RecordTable recordTable;
+
+    // all threads pack the same records in different orders, forcing resizes of the index
+    std::vector<RamDomain> values = testutil::generateRandomVector<RamDomain>(numRecords * arity);
+    std::vector<std::vector<RamDomain>> refs(4, std::vector<RamDomain>(numRecords));
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < refs.size(); ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t k = 0; k < numRecords; ++k) {
+                size_t i = (t % 2 == 0) ? k : numRecords - 1 - k;
+                refs[t][i] = recordTable.pack(&values[i * arity], arity);
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    // equal records share a reference, and references are dense
+    size_t mismatches = 0;
+    for (size_t t = 1; t < refs.size(); ++t) {
+        mismatches += (refs[t] != refs[0]);
+    }
+    EXPECT_EQ(0, mismatches);
+    std::vector<RamDomain> distinct = refs[0];
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+    EXPECT_EQ(1, distinct.front());
+    EXPECT_EQ(static_cast<RamDomain>(distinct.size()), distinct.back());
+    for (size_t i = 0; i < numRecords; ++i) {
+        const RamDomain* unpacked = recordTable.unpack(refs[0][i], arity);
+        mismatches += !std::equal(unpacked, unpacked + arity, &values[i * arity]);
+    }
+    EXPECT_EQ(0, mismatches);
+}
+
+// Build a complete binary tree of records of the given depth, leaves being numbered from first on
+RamDomain packTree(RecordTable& recordTable, size_t depth, RamDomain first) {
+    if (depth == 0) {
+        return first;
+    }
+    RamDomain children[3] = {packTree(recordTable, depth - 1, first),
+            packTree(recordTable, depth - 1, first + (RamDomain(1) << (depth - 1))),
+            static_cast<RamDomain>(depth)};
+    return recordTable.pack(children, 3);
+}
+
+// Sum up the leaves of a tree of records, unpacking subtrees as tasks
+RamDomain sumTree(const RecordTable& recordTable, RamDomain ref, size_t depth) {
+    if (depth == 0) {
+        return ref;
+    }
+    const RamDomain* node = recordTable.unpack(ref, 3);
+    RamDomain left = 0;
+    RamDomain right = 0;
+    task_spawn(left = sumTree(recordTable, node[0], depth - 1));
+    task_spawn(right = sumTree(recordTable, node[1], depth - 1));
+    task_sync;
+    return left + right;
+}
+
+TEST(Tasks, RecursiveUnpack) {
+    constexpr size_t depth = 14;
+    RecordTable recordTable;
+    RamDomain root = packTree(recordTable, depth, 0);
+
+    RamDomain numLeaves = RamDomain(1) << depth;
+    EXPECT_EQ(numLeaves * (numLeaves - 1) / 2, sumTree(recordTable, root, depth));
+
+    // tasks spawned by concurrent threads
+    std::vector<RamDomain> sums(4);
+#pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < sums.size(); ++i) {
+        sums[i] = sumTree(recordTable, root, depth);
+    }
+    for (RamDomain sum : sums) {
+        EXPECT_EQ(numLeaves * (numLeaves - 1) / 2, sum);
+    }
+}
+
 }  // namespace souffle::test
@@ -70,6 +70,7 @@ int main(int argc, char** argv) {
     std::cout << "numOfEntries: " << numOfEntries << std::endl;
     std::cout << "numOfRecords(arity): " << numOfRecords << std::endl;
     std::cout << "recordLength: " << recordLength << std::endl;
+    std::cout << "pages: " << souffle::defaultPagePolicy().toString() << std::endl;
     std::cout << "# of threads\tpack\t\tunpack\n";
 
     std::array<double,2> durations;
@@ -77,6 +78,8 @@ int main(int argc, char** argv) {
         durations = test(numOfThreads, numOfEntries, numOfRecords, &records);
         std::cout << i << "\t\t" << durations[0] << " s\t" << durations[1] << " s\n";
     }
+    std::cout << "applied pages: " << souffle::appliedPagePolicy(souffle::defaultPagePolicy()).toString()
+              << std::endl;
 }
 
 std::array<double,2> test(int numOfThreads, int numOfEntries, int numOfRecords,
@@ -19,6 +19,7 @@
 #include "souffle/CompiledTuple.h"
 #include "souffle/RamTypes.h"
 #include "souffle/RecordTable.h"
+#include <algorithm>
 #include <functional>
 #include <iostream>
 #include <limits>
@@ -111,4 +112,34 @@ TEST(PackUnpack, Vector) {
     }
 }
 
+TEST(Pack, WideRecords) {
+    // records differing in a single value, at every position of a wide record, get different references;
+    // equal records get the same one
+    constexpr size_t arity = 37;
+    RecordMap recordMap(arity);
+
+    std::vector<RamDomain> base(arity);
+    for (size_t i = 0; i < arity; ++i) {
+        base[i] = static_cast<RamDomain>(i * 7);
+    }
+    RamDomain baseRef = recordMap.pack(base);
+    EXPECT_EQ(baseRef, recordMap.pack(base.data()));
+
+    std::vector<RamDomain> refs;
+    for (size_t i = 0; i < arity; ++i) {
+        std::vector<RamDomain> record = base;
+        record[i] += 1;
+        RamDomain ref = recordMap.pack(record.data());
+        EXPECT_TRUE(ref != baseRef);
+        EXPECT_EQ(ref, recordMap.pack(record));
+        refs.push_back(ref);
+        const RamDomain* unpacked = recordMap.unpack(ref);
+        for (size_t j = 0; j < arity; ++j) {
+            EXPECT_EQ(record[j], unpacked[j]);
+        }
+    }
+    std::sort(refs.begin(), refs.end());
+    EXPECT_TRUE(std::unique(refs.begin(), refs.end()) == refs.end());
+}
+
 }  // namespace souffle::test
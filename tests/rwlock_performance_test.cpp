@@ -0,0 +1,115 @@
+/************************************************************************
+ *
+ * @file rwlock_performance_test.cpp
+ *
+ * Measures the latency of writers of souffle's read/write locks under
+ * a continuous read load.
+ *
+ ***********************************************************************/
+
+#include "souffle/utility/ParallelUtil.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct Latencies {
+    double p50;
+    double p99;
+    double max;
+    size_t reads;
+};
+
+void printLatencies(const std::string& lock, const Latencies& latencies);
+
+// readers hold the lock for a short critical section, back to back
+template <typename Lock>
+Latencies measure(int numOfReaders, int numOfWrites) {
+    Lock lock;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> reads{0};
+    volatile size_t data = 0;
+
+    std::vector<std::thread> readers;
+    for (int i = 0; i < numOfReaders; ++i) {
+        readers.emplace_back([&]() {
+            size_t count = 0;
+            size_t seen = 0;
+            while (!done.load(std::memory_order_relaxed)) {
+                lock.start_read();
+                for (int j = 0; j < 64; ++j) {
+                    seen += data;
+                }
+                lock.end_read();
+                ++count;
+            }
+            (void)seen;
+            reads += count;
+        });
+    }
+
+    // give the readers time to start
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    std::vector<double> latencies;
+    for (int i = 0; i < numOfWrites; ++i) {
+        std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+        lock.start_write();
+        std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+        data = data + 1;
+        lock.end_write();
+        latencies.push_back(std::chrono::duration<double, std::micro>(endTime - startTime).count());
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+
+    done = true;
+    for (auto& reader : readers) {
+        reader.join();
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies[std::min(latencies.size() - 1, static_cast<size_t>(p * latencies.size()))];
+    };
+    return {percentile(0.5), percentile(0.99), latencies.back(), reads.load()};
+}
+
+// argv[1]: num of reader threads
+// argv[2]: num of writes
+int main(int argc, char** argv) {
+    int numOfReaders = 4;
+    int numOfWrites = 1000;
+
+    if (argc > 1) {
+        numOfReaders = std::stoi(argv[1]);
+        if (numOfReaders == 0) {
+            std::cerr << "invalid argument! numOfReaders = 0" << std::endl;
+            exit(1);
+        }
+    }
+    if (argc > 2) {
+        numOfWrites = std::stoi(argv[2]);
+        if (numOfWrites <= 0) {
+            std::cerr << "invalid argument! numOfWrites <= 0" << std::endl;
+            exit(1);
+        }
+    }
+    std::cout << "numOfReaders: " << numOfReaders << ", numOfWrites: " << numOfWrites << std::endl;
+
+    std::cout << "lock\t\twrite p50\twrite p99\twrite max\treads" << std::endl;
+    printLatencies("rw", measure<souffle::ReadWriteLock>(numOfReaders, numOfWrites));
+    printLatencies("phase-fair", measure<souffle::PhaseFairReadWriteLock>(numOfReaders, numOfWrites));
+    printLatencies("biased", measure<souffle::BiasedReadWriteLock>(numOfReaders, numOfWrites));
+}
+
+void printLatencies(const std::string& lock, const Latencies& latencies) {
+    std::cout << lock << (lock.size() < 8 ? "\t\t" : "\t")
+        << std::to_string(latencies.p50) << " us\t"
+        << std::to_string(latencies.p99) << " us\t"
+        << std::to_string(latencies.max) << " us\t"
+        << latencies.reads << "\n";
+}
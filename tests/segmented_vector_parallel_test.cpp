@@ -0,0 +1,61 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file segmented_vector_parallel_test.cpp
+ *
+ * Tests the segmented vector in parallel.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/utility/SegmentedVector.h"
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+TEST(SegmentedVector, ConcurrentAppend) {
+    // appends of single elements and of ranges interleave, and their indices are disjoint
+    SegmentedVector<size_t> vector;
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&vector, t]() {
+            for (size_t i = 0; i < 5000; ++i) {
+                size_t first = (i % 8 == 0) ? vector.grow_by(5, t + 1) : vector.push_back(t + 1);
+                if (vector[first] != t + 1) {
+                    vector.push_back(0);
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    std::vector<size_t> counts(5);
+    for (size_t i = 0; i < vector.size(); ++i) {
+        ++counts[vector[i]];
+    }
+    EXPECT_EQ(0, counts[0]);
+    for (size_t t = 1; t <= 4; ++t) {
+        EXPECT_EQ(625 * 5 + 4375, counts[t]);
+    }
+
+    // elements stay in place while the vector grows
+    const size_t* first = &vector[0];
+    vector.grow_by(100000, 0);
+    EXPECT_EQ(first, &vector[0]);
+    EXPECT_EQ(20000 + 4 * 625 * 4 + 100000, vector.size());
+}
+
+}  // namespace souffle::test
@@ -0,0 +1,69 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file simd_util_test.cpp
+ *
+ * Tests the vectorized search kernels.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/utility/SimdUtil.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+// Count the positions of a single difference in N values that a comparison does not locate, for N known
+// at compile time and not
+template <size_t N>
+size_t countMismatchErrors() {
+    size_t errors = 0;
+    std::vector<RamDomain> a(N, 7);
+    for (size_t i = 0; i <= N; ++i) {
+        std::vector<RamDomain> b = a;
+        if (i < N) {
+            b[i] = -7;
+        }
+        errors += simd::firstMismatch<N>(a.data(), b.data()) != i;
+        errors += simd::firstMismatch(a.data(), b.data(), N) != i;
+    }
+    return errors;
+}
+
+TEST(Simd, Search) {
+    // mismatches and needles are found in every block, including the partial blocks of the vector kernels
+    EXPECT_EQ(0, countMismatchErrors<1>());
+    EXPECT_EQ(0, countMismatchErrors<4>());
+    EXPECT_EQ(0, countMismatchErrors<5>());
+    EXPECT_EQ(0, countMismatchErrors<8>());
+    EXPECT_EQ(0, countMismatchErrors<13>());
+    EXPECT_EQ(0, countMismatchErrors<35>());
+
+    size_t errors = 0;
+    for (size_t n : {7, 16, 31, 32, 45, 64, 100}) {
+        std::string text(n, 'a');
+        errors += simd::findFirstOf(text.data(), n, ',', '"') != n;
+        for (size_t i = 0; i < n; ++i) {
+            std::string needle = text;
+            needle[i] = i % 2 == 0 ? ',' : '"';
+            needle[std::max(i, n - 1)] = ',';
+            errors += simd::findFirstOf(needle.data(), n, ',', '"') != i;
+        }
+    }
+    EXPECT_EQ(0, errors);
+}
+
+}  // namespace souffle::test
@@ -0,0 +1,45 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file sort_util_parallel_test.cpp
+ *
+ * Tests radix sorting in parallel.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/SortUtil.h"
+#include <algorithm>
+#include <vector>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+#define NUMBER_OF_TESTS 1000
+
+TEST(RadixSort, Parallel) {
+    using tupleType = Tuple<RamDomain, 2>;
+    std::vector<tupleType> tuples(NUMBER_OF_TESTS * 1000);
+    auto values = testutil::generateRandomVector<RamDomain>(2 * tuples.size());
+    for (size_t i = 0; i < tuples.size(); ++i) {
+        tuples[i] = {{values[2 * i] % 1000, values[2 * i + 1]}};
+    }
+
+    std::vector<tupleType> expected = tuples;
+    std::stable_sort(expected.begin(), expected.end());
+    radixSort(tuples);
+    EXPECT_TRUE(tuples == expected);
+}
+
+}  // namespace souffle::test
@@ -0,0 +1,66 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file sort_util_test.cpp
+ *
+ * Tests radix sorting.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/CompiledTuple.h"
+#include "souffle/RamTypes.h"
+#include "souffle/utility/SortUtil.h"
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <cstddef>
+
+namespace souffle::test {
+
+TEST(RadixSort, ColumnOrders) {
+    // radix sorting agrees with a stable comparison sort, for every column order
+    using tupleType = Tuple<RamDomain, 3>;
+    std::default_random_engine randomGenerator(5);
+    std::uniform_int_distribution<RamDomain> wide(
+            std::numeric_limits<RamDomain>::lowest(), std::numeric_limits<RamDomain>::max());
+    std::uniform_int_distribution<RamDomain> narrow(-50, 50);
+
+    for (size_t n : {size_t(10), size_t(100000)}) {
+        std::vector<tupleType> tuples(n);
+        for (auto& tuple : tuples) {
+            tuple = {{narrow(randomGenerator), wide(randomGenerator), narrow(randomGenerator)}};
+        }
+
+        std::vector<tupleType> sorted = tuples;
+        radixSort(sorted);
+        EXPECT_TRUE(std::is_sorted(sorted.begin(), sorted.end()));
+
+        for (std::vector<size_t> order : {std::vector<size_t>{2, 0}, std::vector<size_t>{1, 2, 0}}) {
+            std::vector<tupleType> expected = tuples;
+            std::stable_sort(expected.begin(), expected.end(), [&](const auto& a, const auto& b) {
+                for (size_t column : order) {
+                    if (a[column] != b[column]) {
+                        return a[column] < b[column];
+                    }
+                }
+                return false;
+            });
+            sorted = tuples;
+            radixSort(sorted, order);
+            EXPECT_TRUE(sorted == expected);
+        }
+    }
+}
+
+}  // namespace souffle::test
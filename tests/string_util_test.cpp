@@ -0,0 +1,138 @@
+/*
+ * Souffle - A Datalog Compiler
+ * Copyright (c) 2020, The Souffle Developers. All rights reserved
+ * Licensed under the Universal Permissive License v 1.0 as shown at:
+ * - https://opensource.org/licenses/UPL
+ * - <souffle root>/licenses/SOUFFLE-UPL.txt
+ */
+
+/************************************************************************
+ *
+ * @file string_util_test.cpp
+ *
+ * Tests the string utilities.
+ *
+ ***********************************************************************/
+
+#include "tests/test.h"
+
+#include "souffle/RamTypes.h"
+#include "souffle/SymbolTable.h"
+#include "souffle/utility/StringUtil.h"
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace souffle::test {
+
+TEST(NumberParsing, Parsers) {
+    // numbers of fact files are parsed in place, reporting errors by code
+    RamSigned s = 0;
+    EXPECT_EQ(std::errc(), parseRamSigned(" -42,x", s).ec);
+    EXPECT_EQ(-42, s);
+    EXPECT_EQ(-31, RamSignedFromString("-0x1F", nullptr, 0));
+    EXPECT_EQ(5, RamSignedFromString("0b101", nullptr, 0));
+    EXPECT_EQ(-5, RamSignedFromString("-0b101", nullptr, 2));
+    EXPECT_EQ(5, RamSignedFromString("101", nullptr, 2));
+    EXPECT_EQ(std::numeric_limits<RamSigned>::min(),
+            RamSignedFromString(std::to_string(std::numeric_limits<RamSigned>::min())));
+    EXPECT_EQ(std::errc::result_out_of_range, parseRamSigned("99999999999999999999", s).ec);
+    EXPECT_EQ(std::errc::invalid_argument, parseRamSigned("+-1", s).ec);
+    EXPECT_EQ(std::errc::invalid_argument, parseRamSigned("", s).ec);
+
+    // a prefix without digits is the number 0 followed by a letter
+    size_t position = 0;
+    EXPECT_EQ(0, RamSignedFromString("0x", &position, 16));
+    EXPECT_EQ(1, position);
+
+    RamUnsigned u = 0;
+    EXPECT_EQ(std::errc::invalid_argument, parseRamUnsigned(" -7", u).ec);
+    EXPECT_EQ(255, RamUnsignedFromString("0xff", nullptr, 0));
+    EXPECT_FALSE(canBeParsedAsRamUnsigned(std::to_string(std::numeric_limits<RamUnsigned>::max()) + "0"));
+
+    RamFloat f = 0;
+    EXPECT_EQ(std::errc(), parseRamFloat("-1.5e3", f).ec);
+    EXPECT_EQ(-1500, f);
+    EXPECT_EQ(8, RamFloatFromString("0x1p3"));
+    EXPECT_TRUE(canBeParsedAsRamFloat("inf"));
+    EXPECT_FALSE(canBeParsedAsRamFloat("1.5x"));
+
+    EXPECT_TRUE(canBeParsedAsRamSigned("-0b1101"));
+    EXPECT_FALSE(canBeParsedAsRamSigned("0b"));
+    EXPECT_FALSE(canBeParsedAsRamSigned("12 "));
+}
+
+TEST(StringEscapes, SinglePass) {
+    // strings are escaped and unescaped in a single pass, crossing the blocks scanned at once
+    const std::string plain(40, 'a');
+    EXPECT_EQ(plain, stringify(plain));
+    EXPECT_EQ(plain + "\\\\\\;\\\"\\n\\t", stringify(plain + "\\;\"\n\t"));
+    EXPECT_EQ("a\\\"" + plain + "\\r", escape("a\"" + plain + "\r"));
+    EXPECT_EQ("\\\"x\\\"", escapeJSONstring("\"x\""));
+
+    // escapes are only consumed by the sequence they start
+    EXPECT_EQ(plain + "\\\"\t\\", unescape(plain + "\\\\\"\\t\\"));
+    EXPECT_EQ("\\x\n", unescape("\\x\\n"));
+    EXPECT_EQ("\"" + plain + "\r", unescape(escape("\"" + plain + "\r")));
+    EXPECT_EQ("a-b-", unescape("a::b::", "::", "-"));
+
+    // the overloads taking a sink append to it
+    std::string out = "x";
+    stringify(plain + ";", out);
+    escape("\n", out);
+    EXPECT_EQ("x" + plain + "\\;\\n", out);
+}
+
+TEST(FieldTokenizer, Fields) {
+    // fields are views of the row, unescaped on demand, and interned without copying
+    const std::string row = "a\\tb\t\"c\td\"\t\"e\\\"\"\t\tlast";
+    FieldTokenizer tokenizer(row, '\t', '"');
+    std::vector<std::string> values;
+    std::vector<bool> escaped;
+    std::string buffer;
+    for (FieldTokenizer::Field field; tokenizer.next(field);) {
+        values.emplace_back(field.value(buffer));
+        escaped.push_back(field.escaped);
+    }
+    EXPECT_EQ((std::vector<std::string>{"a\tb", "c\td", "e\"", "", "last"}), values);
+    EXPECT_EQ((std::vector<bool>{true, false, true, false, false}), escaped);
+
+    // text after a closing quote is an error rather than being dropped
+    auto fieldsOf = [](const std::string& str, char quote) {
+        std::vector<std::string> fields;
+        FieldTokenizer tokenizer(str, '\t', quote);
+        for (FieldTokenizer::Field field; tokenizer.next(field);) {
+            fields.emplace_back(field.text);
+        }
+        return fields;
+    };
+    bool rejected = false;
+    try {
+        fieldsOf("\"e\\\"\"x\tlast", '"');
+    } catch (const std::invalid_argument&) {
+        rejected = true;
+    }
+    EXPECT_TRUE(rejected);
+    EXPECT_EQ((std::vector<std::string>{"a", "b\tc"}), fieldsOf("\"a\"\t\"b\tc\"\t", '"'));
+    EXPECT_EQ((std::vector<std::string>{"open\tend"}), fieldsOf("\"open\tend", '"'));
+
+    // without quotes, a trailing delimiter does not start a field and escaped delimiters still split
+    const std::string x40(40, 'x');
+    EXPECT_EQ((std::vector<std::string>{}), fieldsOf("", '\0'));
+    EXPECT_EQ((std::vector<std::string>{""}), fieldsOf("\t", '\0'));
+    EXPECT_EQ((std::vector<std::string>{"a", "", "b"}), fieldsOf("a\t\tb\t", '\0'));
+    EXPECT_EQ((std::vector<std::string>{x40 + "\\", "\"y\""}), fieldsOf(x40 + "\\\t\"y\"\t", '\0'));
+
+    SymbolTable table;
+    FieldTokenizer symbols("x,y,x", ',');
+    std::vector<RamDomain> indices;
+    for (FieldTokenizer::Field field; symbols.next(field);) {
+        indices.push_back(table.lookup(field.value(buffer)));
+    }
+    EXPECT_EQ((std::vector<RamDomain>{0, 1, 0}), indices);
+    EXPECT_EQ(2, table.size());
+}
+
+}  // namespace souffle::test
@@ -19,9 +19,11 @@
 #include "souffle/SymbolTable.h"
 #include "souffle/utility/MiscUtil.h"
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <iostream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace souffle::test {
@@ -66,4 +68,156 @@ TEST(SymbolTable, Basics_DifferentInputs) {
     }
 }
 
+TEST(SymbolTable, LookupAll_Deterministic) {
+    const int N = 10000;
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < N; i++) {
+        symbols.push_back("Hello" + std::to_string((i * 7919) % (N / 4)));
+    }
+
+    // expected numbering: order of first occurrence
+    SymbolTable expected;
+    for (const auto& symbol : symbols) {
+        expected.lookup(symbol);
+    }
+
+    for (int run = 0; run < 4; run++) {
+        SymbolTable table;
+        std::vector<RamDomain> indices = table.lookupAll(symbols);
+        EXPECT_EQ(table.size(), expected.size());
+        for (int i = 0; i < N; i++) {
+            EXPECT_EQ(indices[i], expected.lookup(symbols[i]));
+        }
+    }
+}
+
+TEST(SymbolTable, LookupAll_ConcurrentLookups) {
+    const int N = 10000;
+
+    std::vector<std::string> symbols;
+    for (int i = 0; i < N; i++) {
+        symbols.push_back("Hello" + std::to_string(i % (N / 2)));
+    }
+
+    SymbolTable table;
+    std::vector<RamDomain> indices;
+
+#pragma omp parallel num_threads(4)
+    {
+#pragma omp single nowait
+        indices = table.lookupAll(symbols);
+
+#pragma omp for
+        for (int i = 0; i < N; i++) {
+            table.lookup(symbols[N - 1 - i]);
+        }
+    }
+
+    EXPECT_EQ(table.size(), N / 2);
+    for (int i = 0; i < N; i++) {
+        EXPECT_STREQ(symbols[i], table.resolve(indices[i]));
+    }
+}
+
+TEST(SymbolTable, LookupAll_NestedLoops) {
+    const int M = 8;
+    const int N = 20000;
+
+    // every iteration of the outer loop interns a batch while others hold the lock of the table
+    SymbolTable table;
+    std::vector<std::vector<RamDomain>> indices(M);
+    parallelFor(
+            0, M,
+            [&](std::size_t j) {
+                std::vector<std::string> symbols;
+                for (int i = 0; i < N; i++) {
+                    symbols.push_back("Hello" + std::to_string((i + j * N / 2) % (M * N / 2)));
+                }
+                indices[j] = table.lookupAll(symbols);
+            },
+            1);
+
+    EXPECT_EQ(table.size(), M * N / 2);
+    for (int j = 0; j < M; j++) {
+        for (int i = 0; i < N; i++) {
+            const std::string str = "Hello" + std::to_string((i + j * N / 2) % (M * N / 2));
+            EXPECT_STREQ(str, table.resolve(indices[j][i]));
+        }
+    }
+}
+
+TEST(SymbolTable, ResolveWhileInserting) {
+    const int M = 20;
+    const int N = 5000;
+
+    // a reader resolves the last published index while batches and single symbols are interned
+    SymbolTable table;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> unexpected{0};
+    std::thread reader([&]() {
+        while (!done.load()) {
+            const size_t n = table.size();
+            if (n > 0 && table.resolve(static_cast<RamDomain>(n - 1)).substr(0, 5) != "Hello") {
+                ++unexpected;
+            }
+        }
+    });
+    std::thread writer([&]() {
+        for (int i = 0; i < M * N; i++) {
+            table.lookup("Hello" + std::to_string(i) + "/single");
+        }
+    });
+    for (int j = 0; j < M; j++) {
+        std::vector<std::string> symbols;
+        for (int i = 0; i < N; i++) {
+            symbols.push_back("Hello" + std::to_string(j * N + i) + "/batch");
+        }
+        table.lookupAll(symbols);
+    }
+    writer.join();
+    done.store(true);
+    reader.join();
+
+    EXPECT_EQ(table.size(), 2 * M * N);
+    EXPECT_EQ(unexpected.load(), 0);
+}
+
+TEST(SymbolTable, Merge_ThreadLocalTables) {
+    const int T = 4;
+    const int N = 10000;
+
+    // each worker interns into its own table
+    std::vector<SymbolTable> locals(T);
+    std::vector<std::vector<RamDomain>> columns(T);
+#pragma omp parallel for num_threads(T)
+    for (int t = 0; t < T; t++) {
+        for (int i = 0; i < N; i++) {
+            columns[t].push_back(locals[t].lookup("Hello" + std::to_string((i * (t + 1)) % N)));
+        }
+    }
+
+    std::vector<const SymbolTable*> tables;
+    for (const auto& local : locals) {
+        tables.push_back(&local);
+    }
+    SymbolTable global;
+    std::vector<std::vector<RamDomain>> remaps = global.merge(tables);
+    EXPECT_EQ(global.size(), N);
+
+    // merging all tables at once equals merging them one after the other
+    SymbolTable sequential;
+    for (int t = 0; t < T; t++) {
+        EXPECT_EQ(toString(remaps[t]), toString(sequential.merge(locals[t])));
+    }
+
+    for (int t = 0; t < T; t++) {
+        std::vector<RamDomain> column = columns[t];
+        remapColumn(column.data(), column.size(), 1, 0, remaps[t]);
+        for (int i = 0; i < N; i++) {
+            EXPECT_STREQ(global.resolve(column[i]), locals[t].resolve(columns[t][i]));
+        }
+    }
+}
+
 }  // namespace souffle::test
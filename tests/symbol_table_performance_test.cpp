@@ -9,6 +9,7 @@
 
 #include "souffle/SymbolTable.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/ParallelUtil.h"
 #include <algorithm>
 #include <cstddef>
 #include <iostream>
@@ -16,7 +17,17 @@
 #include <vector>
 #include <fstream>
 
-void printDuration(int numOfThreads, double insertTime, double lookupTime, double resolveTime);
+void printDuration(int numOfThreads, double insertTime, double bulkInsertTime, double lookupTime, double resolveTime);
+
+// limit the threads of the parallel loops, where the backend allows to (OpenMP); the loops run on the
+// selected backend by parallelFor
+void setNumOfThreads(int numOfThreads) {
+#ifdef _OPENMP
+    omp_set_num_threads(numOfThreads);
+#else
+    (void)numOfThreads;
+#endif
+}
 
 std::vector<std::string> getRandomStrings(std::string filePath, int stringLength){
     int minStringLength = 6;
@@ -59,12 +70,25 @@ double insert(std::vector<std::string> *randomStrings) {
 double insertInParallel(int numOfThreads, std::vector<std::string> *randomStrings){
 
     souffle::SymbolTable table;
+    setNumOfThreads(numOfThreads);
     //start
     std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
-#pragma omp parallel for num_threads(numOfThreads)
-    for(std::vector<std::string>::size_type i = 0; i < randomStrings->size(); i++) {
+    souffle::parallelFor(0, randomStrings->size(), [&](std::size_t i) {
         table.lookup(randomStrings->at(i));
-    }
+    });
+    //end
+    std::chrono::system_clock::time_point endTime = std::chrono::system_clock::now();
+    std::chrono::duration<double> elapsed_seconds = endTime - startTime;
+    return elapsed_seconds.count();
+}
+
+double insertBulk(int numOfThreads, std::vector<std::string> *randomStrings){
+
+    souffle::SymbolTable table;
+    setNumOfThreads(numOfThreads);
+    //start
+    std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
+    table.lookupAll(*randomStrings);
     //end
     std::chrono::system_clock::time_point endTime = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = endTime - startTime;
@@ -99,11 +123,11 @@ double lookupInParallel(int numOfThreads, std::vector<std::string> *randomString
     }
 
     //start
+    setNumOfThreads(numOfThreads);
     std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
-#pragma omp parallel for num_threads(numOfThreads)
-    for(std::vector<std::string>::size_type i = 0; i < randomStrings->size(); i++) {
+    souffle::parallelFor(0, randomStrings->size(), [&](std::size_t i) {
         table.lookup(randomStrings->at(i));
-    }
+    });
     //end
     std::chrono::system_clock::time_point endTime = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = endTime - startTime;
@@ -142,11 +166,11 @@ double resolveInParallel(int numOfThreads, std::vector<std::string> *randomStrin
     }
 
     //start
+    setNumOfThreads(numOfThreads);
     std::chrono::system_clock::time_point startTime = std::chrono::system_clock::now();
-#pragma omp parallel for num_threads(numOfThreads)
-    for(std::vector<size_t>::size_type i = 0; i < indices.size(); i++) {
+    souffle::parallelFor(0, indices.size(), [&](std::size_t i) {
         table.resolve(indices[i]);
-    }
+    });
     //end
     std::chrono::system_clock::time_point endTime = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = endTime - startTime;
@@ -156,6 +180,7 @@ double resolveInParallel(int numOfThreads, std::vector<std::string> *randomStrin
 // argv[1]: num of threads. no use multi-threading if 0
 // argv[2]: length of symbol string (6 <= length <= 20) if not exist or -1, length is random
 // argv[3]: file path of random strings
+// argv[4..]: loop schedules of the bulk insert to sweep, e.g. static dynamic,64 guided auto
 int main(int argc, char** argv) {
     int maxNumOfThreads = 1;
     std::string filePath = "randomStrings.txt";
@@ -182,31 +207,48 @@ int main(int argc, char** argv) {
         filePath = argv[3];
     }
 
+    std::vector<std::string> schedules;
+    for (int i = 4; i < argc; ++i) {
+        schedules.push_back(argv[i]);
+    }
+    if (schedules.empty()) {
+        schedules.push_back(souffle::defaultLoopSchedule().toString());
+    }
+
     std::vector<std::string> randomStrings = getRandomStrings(filePath, stringLength);
     std::cout << "numOfStrings: " + std::to_string(randomStrings.size()) << std::endl;
+    std::cout << "pages: " << souffle::defaultPagePolicy().toString() << std::endl;
 
-
-    std::cout << "# of threads\tinsert\t\tlookup\t\tresolve" << std::endl;
     double insertTime;
+    double bulkInsertTime;
     double lookupTime;
     double resolveTime;
-    for (int numOfThreads = 1; numOfThreads <= maxNumOfThreads; ++numOfThreads) {
-        if(numOfThreads > 1) {
-            insertTime = insertInParallel(numOfThreads, &randomStrings);
-            lookupTime = lookupInParallel(numOfThreads, &randomStrings);
-            resolveTime = resolveInParallel(numOfThreads, &randomStrings);
-        } else {
-            insertTime = insert(&randomStrings);
-            lookupTime = lookup(&randomStrings);
-            resolveTime = resolve(&randomStrings);
+    for (const std::string& schedule : schedules) {
+        souffle::defaultLoopSchedule() = souffle::LoopSchedule::parse(schedule);
+        std::cout << "schedule: " << souffle::defaultLoopSchedule().toString() << std::endl;
+        std::cout << "# of threads\tinsert\t\tbulk insert\tlookup\t\tresolve" << std::endl;
+        for (int numOfThreads = 1; numOfThreads <= maxNumOfThreads; ++numOfThreads) {
+            if(numOfThreads > 1) {
+                insertTime = insertInParallel(numOfThreads, &randomStrings);
+                lookupTime = lookupInParallel(numOfThreads, &randomStrings);
+                resolveTime = resolveInParallel(numOfThreads, &randomStrings);
+            } else {
+                insertTime = insert(&randomStrings);
+                lookupTime = lookup(&randomStrings);
+                resolveTime = resolve(&randomStrings);
+            }
+            bulkInsertTime = insertBulk(numOfThreads, &randomStrings);
+            printDuration(numOfThreads, insertTime, bulkInsertTime, lookupTime, resolveTime);
         }
-        printDuration(numOfThreads, insertTime, lookupTime, resolveTime);
     }
+    std::cout << "applied pages: " << souffle::appliedPagePolicy(souffle::defaultPagePolicy()).toString()
+              << std::endl;
 }
 
-void printDuration(int numOfThreads, double insertTime, double lookupTime, double resolveTime) {
+void printDuration(int numOfThreads, double insertTime, double bulkInsertTime, double lookupTime, double resolveTime) {
     std::cout << numOfThreads << "\t\t"
         << std::to_string(insertTime) << " s\t"
+        << std::to_string(bulkInsertTime) << " s\t"
         << std::to_string(lookupTime) << " s\t"
         << std::to_string(resolveTime) << " s\n";
 }
\ No newline at end of file
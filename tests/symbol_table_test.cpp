@@ -16,12 +16,19 @@
 
 #include "tests/test.h"
 
+#include "souffle/CompressedSymbolTable.h"
+#include "souffle/SymbolSearchIndex.h"
 #include "souffle/SymbolTable.h"
 #include "souffle/utility/MiscUtil.h"
+#include "souffle/utility/PageAllocator.h"
 #include <algorithm>
 #include <cstddef>
 #include <iostream>
+#include <memory_resource>
+#include <set>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
 namespace souffle::test {
@@ -44,4 +51,267 @@ TEST(SymbolTable, Inserts) {
     EXPECT_EQ(X.size(), 4);
 }
 
+TEST(SymbolTable, LookupAll) {
+    SymbolTable table({"B"});
+
+    std::vector<RamDomain> indices = table.lookupAll({"A", "B", "C", "A", "D", "C"});
+    EXPECT_EQ(table.size(), 4);
+    EXPECT_EQ(toString(indices), toString(std::vector<RamDomain>({1, 0, 2, 1, 3, 2})));
+
+    for (size_t i = 0; i < indices.size(); ++i) {
+        EXPECT_EQ(indices[i], table.lookup(table.resolve(indices[i])));
+    }
+}
+
+TEST(SymbolTable, Merge) {
+    SymbolTable global({"A", "B"});
+    SymbolTable local({"C", "A", "D"});
+
+    std::vector<RamDomain> remap = global.merge(local);
+    EXPECT_EQ(global.size(), 4);
+    EXPECT_EQ(toString(remap), toString(std::vector<RamDomain>({2, 0, 3})));
+
+    // tuples of arity 2 with local symbols in the second column
+    const std::vector<RamDomain> original = {7, 0, 7, 1, 7, 2, 7, 2, 7, 1, 7, 0, 7, 0, 7, 1, 7, 2, 7, 1};
+    std::vector<RamDomain> tuples = original;
+    remapColumn(tuples.data(), tuples.size() / 2, 2, 1, remap);
+    for (size_t i = 0; i < tuples.size(); i += 2) {
+        EXPECT_EQ(tuples[i], 7);
+        EXPECT_STREQ(global.resolve(tuples[i + 1]), local.resolve(original[i + 1]));
+    }
+}
+
+TEST(SymbolTable, Renumber) {
+    SymbolTable table({"D", "B", "C", "A"});
+
+    std::vector<RamDomain> remap = table.renumberByFrequency({1, 5, 0, 5});
+    EXPECT_EQ(toString(remap), toString(std::vector<RamDomain>({2, 0, 3, 1})));
+    EXPECT_STREQ("B", table.resolve(0));
+    EXPECT_STREQ("A", table.resolve(1));
+    EXPECT_STREQ("D", table.resolve(2));
+    EXPECT_STREQ("C", table.resolve(3));
+    EXPECT_EQ(table.lookup("C"), 3);
+
+    remap = table.renumberSorted();
+    EXPECT_EQ(toString(remap), toString(std::vector<RamDomain>({1, 0, 3, 2})));
+    for (RamDomain i = 0; i < 4; ++i) {
+        EXPECT_EQ(table.lookup(std::string(1, static_cast<char>('A' + i))), i);
+    }
+
+    table.compact();
+    EXPECT_EQ(table.size(), 4);
+    EXPECT_STREQ("C", table.resolve(2));
+    EXPECT_EQ(table.lookup("E"), 4);
+
+    // the characters of long symbols are rebuilt in index order as well
+    SymbolTable paths;
+    for (int i = 0; i < 20; ++i) {
+        paths.lookup("/home/souffle/analysis/input/relation" + std::to_string((i * 7) % 20) + ".facts");
+    }
+    paths.renumberSorted();
+    for (RamDomain i = 1; i < 20; ++i) {
+        EXPECT_LT(paths.resolve(i - 1).data(), paths.resolve(i).data());
+        EXPECT_LT(paths.resolve(i).data() - paths.resolve(i - 1).data(), 128);
+    }
+}
+
+TEST(SymbolTable, UpstreamAllocations) {
+    // a resource recording the blocks it passes on from the default resource
+    struct RecordingResource : public std::pmr::memory_resource {
+        std::vector<std::pair<const char*, size_t>> blocks;
+
+        void* do_allocate(size_t size, size_t alignment) override {
+            void* block = std::pmr::get_default_resource()->allocate(size, alignment);
+            blocks.emplace_back(static_cast<const char*>(block), size);
+            return block;
+        }
+        void do_deallocate(void* pointer, size_t size, size_t alignment) override {
+            std::pmr::get_default_resource()->deallocate(pointer, size, alignment);
+        }
+        bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+            return this == &other;
+        }
+        bool owns(std::string_view symbol) const {
+            return std::any_of(blocks.begin(), blocks.end(), [&](const auto& block) {
+                const char* end = block.first + block.second;
+                return block.first <= symbol.data() && symbol.data() + symbol.size() <= end;
+            });
+        }
+    };
+
+    // the characters of symbols exceeding the short-string buffer of std::string are taken from the
+    // resource in a few chunks, instead of one allocation each
+    const size_t N = 10000;
+    RecordingResource upstream;
+    SymbolTable table(defaultPagePolicy(), &upstream);
+    for (size_t i = 0; i < N; ++i) {
+        table.lookup("/home/souffle/analysis/input/relation" + std::to_string(i) + ".facts");
+    }
+    std::vector<std::string> more;
+    for (size_t i = 0; i < N; ++i) {
+        more.push_back("/home/souffle/analysis/output/relation" + std::to_string(i) + ".csv");
+    }
+    table.lookupAll(more);
+    EXPECT_EQ(table.size(), 2 * N);
+    EXPECT_LT(upstream.blocks.size(), N / 100);
+
+    size_t foreign = 0;
+    for (size_t i = 0; i < table.size(); ++i) {
+        foreign += upstream.owns(table.resolve(static_cast<RamDomain>(i))) ? 0 : 1;
+    }
+    EXPECT_EQ(foreign, 0);
+    EXPECT_STREQ(more.back(), table.resolve(static_cast<RamDomain>(2 * N - 1)));
+}
+
+TEST(SymbolTable, Ordered) {
+    SymbolTable table({"/usr/lib", "/home/b", "/usr/bin", "/home/a", "/usr/bin/env", "/var"});
+    EXPECT_FALSE(table.isOrdered());
+
+    table.renumberSorted();
+    EXPECT_TRUE(table.isOrdered());
+    EXPECT_LT(table.lookup("/home/b"), table.lookup("/usr/bin"));
+
+    auto range = table.prefixRange("/usr/");
+    EXPECT_EQ(range.first, table.lookup("/usr/bin"));
+    EXPECT_EQ(range.second, table.lookup("/var"));
+    EXPECT_EQ(table.prefixRange("/usr/bin").second - table.prefixRange("/usr/bin").first, 2);
+    EXPECT_EQ(table.prefixRange("/opt").first, table.prefixRange("/opt").second);
+    EXPECT_EQ(table.prefixRange("").second, 6);
+    EXPECT_EQ(table.lowerBound("/o"), table.lookup("/usr/bin"));
+
+    // appending in increasing order preserves the order, otherwise it is lost
+    table.lookup("/zzz");
+    EXPECT_TRUE(table.isOrdered());
+    table.lookup("/a");
+    EXPECT_FALSE(table.isOrdered());
+}
+
+TEST(SymbolSearchIndex, Queries) {
+    SymbolTable table({"http://a.org/x", "http://b.org/", "ftp://a.org/x", "http", "a.org"});
+    SymbolSearchIndex index(table);
+    EXPECT_EQ(index.size(), 5);
+
+    EXPECT_EQ(toString(index.withPrefix("http")), toString(std::vector<RamDomain>({3, 0, 1})));
+    EXPECT_EQ(toString(index.withPrefix("http://a")), toString(std::vector<RamDomain>({0})));
+    EXPECT_TRUE(index.withPrefix("https").empty());
+
+    EXPECT_EQ(toString(index.containing("a.org")), toString(std::vector<RamDomain>({0, 2, 4})));
+    EXPECT_EQ(toString(index.containing("/x")), toString(std::vector<RamDomain>({0, 2})));
+    EXPECT_TRUE(index.containing("c.org").empty());
+
+    // symbols added later are covered after an update
+    table.lookup("c.org/http");
+    EXPECT_TRUE(index.containing("c.org").empty());
+    index.update();
+    EXPECT_EQ(toString(index.containing("c.org")), toString(std::vector<RamDomain>({5})));
+    EXPECT_EQ(toString(index.withPrefix("c")), toString(std::vector<RamDomain>({5})));
+    EXPECT_EQ(index.containing("http").size(), 4);
+}
+
+TEST(SymbolSearchIndex, CompressedPostings) {
+    const int N = 20000;
+    SymbolTable table;
+    for (int i = 0; i < N / 2; i++) {
+        table.lookup("dir" + std::to_string(i % 50) + "/file" + std::to_string(i) + ".dl");
+    }
+    SymbolSearchIndex index(table);
+    for (int i = N / 2; i < N; i++) {
+        table.lookup("dir" + std::to_string(i % 50) + "/file" + std::to_string(i) + ".dl");
+    }
+    index.update();
+
+    // the lists extended by the update agree with a scan of all symbols
+    for (const std::string needle : {"dir7/", "file1", "le199", "/file", ".dl", "r4/file12"}) {
+        std::vector<RamDomain> expected;
+        for (RamDomain i = 0; i < N; i++) {
+            if (table.resolve(i).find(needle) != std::string::npos) {
+                expected.push_back(i);
+            }
+        }
+        EXPECT_EQ(toString(index.containing(needle)), toString(expected));
+    }
+    size_t postings = 0;
+    for (RamDomain i = 0; i < N; i++) {
+        const std::string_view symbol = table.resolve(i);
+        std::set<std::string_view> trigrams;
+        for (size_t pos = 0; pos + 3 <= symbol.size(); ++pos) {
+            trigrams.insert(symbol.substr(pos, 3));
+        }
+        postings += trigrams.size();
+    }
+
+    // the gaps of the posting lists take about a byte each, instead of an index of four bytes
+    EXPECT_LT(index.allocatedBytes(), postings * sizeof(RamDomain) / 2);
+}
+
+TEST(SymbolSearchIndex, IncrementalUpdates) {
+    // updates of varying sizes build segments, some of which are merged
+    SymbolTable table;
+    SymbolSearchIndex index(table);
+    int n = 0;
+    for (int batch : {1, 1, 2, 300, 5, 5, 5, 1000, 2, 40, 7, 3000, 1}) {
+        for (int i = 0; i < batch; i++, n++) {
+            table.lookup("x" + std::to_string((n * 7919) % 9973) + "/y" + std::to_string(n % 13));
+        }
+        index.update();
+
+        for (const std::string needle : {"/y1", "99", "x12", "3/y", "y", "/"}) {
+            std::vector<RamDomain> expected;
+            for (RamDomain i = 0; i < n; i++) {
+                if (table.resolve(i).find(needle) != std::string::npos) {
+                    expected.push_back(i);
+                }
+            }
+            EXPECT_EQ(toString(index.containing(needle)), toString(expected));
+        }
+        for (const std::string prefix : {"x1", "x99", "x5"}) {
+            std::vector<RamDomain> expected;
+            for (RamDomain i = 0; i < n; i++) {
+                if (table.resolve(i).substr(0, prefix.size()) == prefix) {
+                    expected.push_back(i);
+                }
+            }
+            std::sort(expected.begin(), expected.end(),
+                    [&](RamDomain a, RamDomain b) { return table.resolve(a) < table.resolve(b); });
+            EXPECT_EQ(toString(index.withPrefix(prefix)), toString(expected));
+        }
+    }
+    EXPECT_EQ(index.size(), static_cast<size_t>(n));
+}
+
+TEST(CompressedSymbolTable, Basics) {
+    std::vector<std::string> sample;
+    for (int i = 0; i < 200; i++) {
+        sample.push_back("https://www.example.org/src/include/souffle/file" + std::to_string(i) + ".h");
+    }
+    CompressedSymbolTable table(SymbolCompressor::train(sample));
+
+    SymbolTable plain;
+    for (const auto& symbol : sample) {
+        table.lookup(symbol);
+        plain.lookup(symbol);
+    }
+    EXPECT_EQ(table.size(), sample.size());
+    EXPECT_LT(table.compressionRatio(plain), 0.5);
+
+    std::string buffer;
+    for (size_t i = 0; i < sample.size(); i++) {
+        EXPECT_EQ(table.lookup(sample[i]), static_cast<RamDomain>(i));
+        EXPECT_STREQ(sample[i], table.resolve(static_cast<RamDomain>(i), buffer));
+    }
+
+    // symbols not covered by the trained table are escaped
+    const std::string unseen = "\x01\xff unseen \xfe";
+    EXPECT_STREQ(unseen, table.resolve(table.lookup(unseen)));
+    EXPECT_STREQ("", table.resolve(table.lookup("")));
+
+    // symbols exceeding a chunk of the storage are stored in chunks of their own
+    const std::string large(3 << 20, '\x01');
+    const RamDomain index = table.lookup(large);
+    EXPECT_STREQ(large, table.resolve(index));
+    EXPECT_EQ(table.lookup(large), index);
+    EXPECT_STREQ(sample[0], table.resolve(table.lookup(sample[0])));
+    EXPECT_STREQ("after", table.resolve(table.lookup("after")));
+}
+
 }  // namespace souffle::test